@@ -0,0 +1,121 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "parser.h"
+#include "linker.h"
+#include "resolver.h"
+#include "compiler.h"
+#include "vm.h"
+#include "output.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Call throughput: plain recursion, tail recursion 1e8 deep (in constant
+// stack space), and the same countdown written as a loop for comparison.
+// Each program echoes its result, which is checked here: a wrong answer
+// makes the benchmark exit non-zero.
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// fib(n) makes 2 * fib(n + 1) - 1 calls
+static const char *fib =
+    ".fib(n)\n"
+    "    if n lt 2\n"
+    "        ret n\n"
+    "    endb\n"
+    "    sub n,1 eq a\n"
+    "    call .fib(a) eq x\n"
+    "    sub n,2 eq b\n"
+    "    call .fib(b) eq y\n"
+    "    add x,y eq r\n"
+    "    ret r\n"
+    "start .main\n"
+    "    call .fib(%d) eq f\n"
+    "    echo f\n";
+
+// Accumulator-style recursion: every call is a tail call
+static const char *tail =
+    ".count(n,acc)\n"
+    "    if n eq 0\n"
+    "        ret acc\n"
+    "    endb\n"
+    "    sub n,1 eq m\n"
+    "    inc acc\n"
+    "    call .count(m,acc) eq r\n"
+    "    ret r\n"
+    "start .main\n"
+    "    call .count(%d,0) eq c\n"
+    "    echo c\n";
+
+static const char *loop =
+    "start .main\n"
+    "    set n,%d\n"
+    "    set acc,0\n"
+    "    while n ne 0\n"
+    "        sub n,1 eq m\n"
+    "        set n,m\n"
+    "        inc acc\n"
+    "    endl\n"
+    "    echo acc\n";
+
+static void run_case(const char *name, const char *template, int n, long long calls,
+                     int expected) {
+    char source[1024];
+    int length = snprintf(source, sizeof(source), template, n);
+
+    Arena *arena = create_arena(64 * 1024);
+    ASTNode *program = parse_source(source, length, arena);
+    if (link_program(program, arena) > 0) exit(1);
+    resolve(program, arena);
+    Proto *proto = compile(program);
+
+    // Capture the program's echo in a temporary file
+    FILE *captured = tmpfile();
+    fflush(stdout);
+    int report = dup(STDOUT_FILENO);
+    dup2(fileno(captured), STDOUT_FILENO);
+
+    double start = now_seconds();
+    vm_run(proto);
+    double elapsed = now_seconds() - start;
+
+    output_flush();
+    dup2(report, STDOUT_FILENO);
+    close(report);
+
+    int result;
+    rewind(captured);
+    if (fscanf(captured, "%d", &result) != 1 || result != expected) {
+        fprintf(stderr, "%s: expected %d\n", name, expected);
+        exit(1);
+    }
+    fclose(captured);
+
+    printf("%-10s %12lld %10.1f %12.2f\n", name, calls,
+           elapsed * 1e3, elapsed * 1e9 / calls);
+
+    free_proto(proto);
+    free_arena(arena);
+}
+
+int main(int argc, char *argv[]) {
+    int depth = 100000000;
+    if (argc > 1) {
+        depth = atoi(argv[1]);
+    }
+
+    printf("%-10s %12s %10s %12s\n", "case", "calls", "ms", "ns/call");
+    long long fib_calls = 2 * 317811 - 1;       // fib(28) = 317811
+    run_case("fib", fib, 27, fib_calls, 196418);
+    run_case("tail", tail, depth, depth, depth);
+    run_case("loop", loop, depth, depth, depth);
+
+    free_symbols();
+    return 0;
+}
@@ -0,0 +1,93 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "parser.h"
+#include "resolver.h"
+#include "compiler.h"
+#include "vm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Comparison cost per operand type pair: a counted loop whose body is one
+// `if a <op> b`, minus the same loop without the comparison
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const char *template =
+    "start .main\n"
+    "    set a,%s\n"
+    "    set b,%s\n"
+    "    set n,0\n"
+    "    for i (1...%d)\n"
+    "        if a %s b\n"
+    "            inc n\n"
+    "        endb\n"
+    "    endl\n";
+
+static const char *baseline =
+    "start .main\n"
+    "    set n,0\n"
+    "    for i (1...%d)\n"
+    "        inc n\n"
+    "    endl\n";
+
+static const struct {
+    const char *name;
+    const char *left;
+    const char *right;
+    const char *op;
+} cases[] = {
+    {"int-int lt", "1", "2", "lt"},
+    {"int-int eq", "1", "2", "eq"},
+    {"float-float lt", "1.5", "2.5", "lt"},
+    {"int-float lt", "1", "2.5", "lt"},
+    {"float-int ge", "1.5", "2", "ge"},
+    {"string eq", "\"apples\"", "\"apricot\"", "eq"},
+    {"string lt", "\"apples\"", "\"apricot\"", "lt"},
+    {"bool-bool ne", "true", "false", "ne"},
+    {"string-int eq", "\"1\"", "1", "eq"},
+};
+
+static double run_source(const char *source, int length) {
+    Arena *arena = create_arena(64 * 1024);
+    ASTNode *program = parse_source(source, length, arena);
+    resolve(program, arena);
+    Proto *proto = compile(program);
+
+    double start = now_seconds();
+    vm_run(proto);
+    double elapsed = now_seconds() - start;
+
+    free_proto(proto);
+    free_arena(arena);
+    return elapsed;
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = 50000000;
+    if (argc > 1) {
+        iterations = atoi(argv[1]);
+    }
+
+    char source[1024];
+    int length = snprintf(source, sizeof(source), baseline, iterations);
+    double empty = run_source(source, length);
+
+    printf("%-16s %10s %12s %12s\n", "case", "ms", "ns/iter", "ns/compare");
+    printf("%-16s %10.1f %12.2f %12s\n", "loop only", empty * 1e3, empty * 1e9 / iterations, "-");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        length = snprintf(source, sizeof(source), template,
+                          cases[i].left, cases[i].right, iterations, cases[i].op);
+        double elapsed = run_source(source, length);
+        printf("%-16s %10.1f %12.2f %12.2f\n", cases[i].name, elapsed * 1e3,
+               elapsed * 1e9 / iterations, (elapsed - empty) * 1e9 / iterations);
+    }
+
+    free_symbols();
+    return 0;
+}
@@ -0,0 +1,73 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "parser.h"
+#include "resolver.h"
+#include "compiler.h"
+#include "vm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// concat throughput in appends/sec as the string grows. In-place appends
+// should hold a steady rate; the copying row keeps a second reference to
+// the string, so every append copies it and the rate falls with length.
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const char *append_in_place =
+    "start .main\n"
+    "    set s,\"\"\n"
+    "    for i (1...%d)\n"
+    "        concat s,\"abcd\" eq s\n"
+    "    endl\n";
+
+static const char *append_shared =
+    "start .main\n"
+    "    set s,\"\"\n"
+    "    for i (1...%d)\n"
+    "        set t,s\n"
+    "        concat s,\"abcd\" eq s\n"
+    "    endl\n";
+
+static double run_program(const char *template, int appends) {
+    char source[1024];
+    int length = snprintf(source, sizeof(source), template, appends);
+
+    Arena *arena = create_arena(64 * 1024);
+    ASTNode *program = parse_source(source, length, arena);
+    resolve(program, arena);
+    Proto *proto = compile(program);
+
+    double start = now_seconds();
+    vm_run(proto);
+    double elapsed = now_seconds() - start;
+
+    free_proto(proto);
+    free_arena(arena);
+    return elapsed;
+}
+
+int main(int argc, char *argv[]) {
+    int appends = 1000000;
+    if (argc > 1) {
+        appends = atoi(argv[1]);
+    }
+
+    printf("%-24s %12s %14s\n", "case", "appends", "appends/sec");
+    for (int n = appends / 100; n <= appends; n *= 10) {
+        double elapsed = run_program(append_in_place, n);
+        printf("%-24s %12d %14.0f\n", "concat in place", n, n / elapsed);
+    }
+    for (int n = appends / 1000; n <= appends / 10; n *= 10) {
+        double elapsed = run_program(append_shared, n);
+        printf("%-24s %12d %14.0f\n", "concat copying", n, n / elapsed);
+    }
+
+    free_symbols();
+    return 0;
+}
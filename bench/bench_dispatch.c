@@ -0,0 +1,83 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "parser.h"
+#include "resolver.h"
+#include "compiler.h"
+#include "vm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// VM dispatch benchmark. Built twice by `make bench`: once with threaded
+// (computed goto) dispatch and once with the portable switch loop.
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Branchy while loop: compare, conditional jumps and small arithmetic
+static const char *branchy =
+    "start .main\n"
+    "    set i,0\n"
+    "    set even,0\n"
+    "    set odd,0\n"
+    "    while i lt %d\n"
+    "        mod i,2 eq r\n"
+    "        if r eq 0\n"
+    "            inc even\n"
+    "        else\n"
+    "            inc odd\n"
+    "        endb\n"
+    "        if i gt 1000\n"
+    "            sub i,1000 eq t\n"
+    "        endb\n"
+    "        inc i\n"
+    "    endl\n";
+
+// Straight-line arithmetic inside a counted loop
+static const char *counted =
+    "start .main\n"
+    "    set s,0\n"
+    "    for i (1...%d)\n"
+    "        add s,i eq s\n"
+    "        mul i,3 eq t\n"
+    "        sub t,s eq u\n"
+    "    endl\n";
+
+static void run_case(const char *name, const char *template, int iterations) {
+    char source[1024];
+    int length = snprintf(source, sizeof(source), template, iterations);
+
+    Arena *arena = create_arena(64 * 1024);
+    ASTNode *program = parse_source(source, length, arena);
+    resolve(program, arena);
+    Proto *proto = compile(program);
+
+    double start = now_seconds();
+    vm_run(proto);
+    double elapsed = now_seconds() - start;
+
+    printf("%-10s %12d %10.1f %12.2f\n", name, iterations,
+           elapsed * 1e3, elapsed * 1e9 / iterations);
+
+    free_proto(proto);
+    free_arena(arena);
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = 10000000;
+    if (argc > 1) {
+        iterations = atoi(argv[1]);
+    }
+
+    printf("dispatch: %s\n", vm_dispatch_mode());
+    printf("%-10s %12s %10s %12s\n", "case", "iterations", "ms", "ns/iter");
+    run_case("branchy", branchy, iterations);
+    run_case("counted", counted, iterations);
+
+    free_symbols();
+    return 0;
+}
@@ -0,0 +1,131 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+// Keyword recognition microbenchmark over identifier-heavy input.
+// Compares the old lowercase + strcmp chain with lookup_keyword().
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Previous implementation, kept here as the baseline
+static TokenType legacy_check_keyword(const char *str, int length) {
+    static const struct { const char *text; TokenType type; } keywords[] = {
+        {"start", TOKEN_START}, {"set", TOKEN_SET}, {"echo", TOKEN_ECHO},
+        {"if", TOKEN_IF}, {"elseif", TOKEN_ELSEIF}, {"else", TOKEN_ELSE},
+        {"endb", TOKEN_ENDB}, {"for", TOKEN_FOR}, {"while", TOKEN_WHILE},
+        {"endl", TOKEN_ENDL}, {"break", TOKEN_BREAK}, {"continue", TOKEN_CONTINUE},
+        {"call", TOKEN_CALL}, {"ret", TOKEN_RET}, {"jmp", TOKEN_JMP},
+        {"jeq", TOKEN_JEQ}, {"jne", TOKEN_JNE}, {"jgt", TOKEN_JGT},
+        {"jlt", TOKEN_JLT}, {"jge", TOKEN_JGE}, {"jle", TOKEN_JLE},
+        {"halt", TOKEN_HALT}, {"type", TOKEN_TYPE}, {"int", TOKEN_INT_CAST},
+        {"float", TOKEN_FLOAT_CAST}, {"str", TOKEN_STR_CAST}, {"bool", TOKEN_BOOL_CAST},
+        {"in", TOKEN_IN}, {"add", TOKEN_ADD}, {"sub", TOKEN_SUB},
+        {"mul", TOKEN_MUL}, {"div", TOKEN_DIV}, {"mod", TOKEN_MOD},
+        {"inc", TOKEN_INC}, {"dec", TOKEN_DEC}, {"concat", TOKEN_CONCAT},
+        {"eq", TOKEN_EQ}, {"ne", TOKEN_NE}, {"gt", TOKEN_GT},
+        {"lt", TOKEN_LT}, {"ge", TOKEN_GE}, {"le", TOKEN_LE},
+        {"and", TOKEN_AND}, {"or", TOKEN_OR}, {"not", TOKEN_NOT},
+        {"true", TOKEN_BOOL_TRUE}, {"false", TOKEN_BOOL_FALSE},
+    };
+    char lower[256];
+    int i = 0;
+    while (i < length && i < 255) {
+        lower[i] = tolower(str[i]);
+        i++;
+    }
+    lower[i] = '\0';
+
+    for (size_t k = 0; k < sizeof(keywords) / sizeof(keywords[0]); k++) {
+        if (strcmp(lower, keywords[k].text) == 0) return keywords[k].type;
+    }
+    return TOKEN_IDENTIFIER;
+}
+
+static const char *words[] = {
+    "counter", "total", "index", "result", "value", "temp", "accumulator",
+    "x", "y", "i", "j", "name", "buffer_size", "row", "column", "Sum",
+    "add", "set", "eq", "ECHO", "While", "endl", "lt", "continue",
+};
+
+// Build an identifier-heavy script of roughly `size` bytes
+static char *generate_source(size_t size, size_t *length) {
+    size_t word_count = sizeof(words) / sizeof(words[0]);
+    char *source = malloc(size + 64);
+    size_t len = 0;
+    size_t w = 0;
+
+    while (len < size) {
+        const char *word = words[w++ % word_count];
+        size_t word_len = strlen(word);
+        memcpy(source + len, word, word_len);
+        len += word_len;
+        source[len++] = (w % 8 == 0) ? '\n' : ' ';
+    }
+    source[len] = '\0';
+    *length = len;
+    return source;
+}
+
+// Classify every identifier in the source with the given function
+static double time_classifier(const char *source, size_t length,
+                              TokenType (*classify)(const char *, int),
+                              long *keyword_count) {
+    long keywords = 0;
+    double start = now_seconds();
+    size_t pos = 0;
+    while (pos < length) {
+        size_t word_start = pos;
+        while (pos < length && (isalnum((unsigned char)source[pos]) || source[pos] == '_')) pos++;
+        if (pos > word_start &&
+            classify(source + word_start, (int)(pos - word_start)) != TOKEN_IDENTIFIER) {
+            keywords++;
+        }
+        pos++;
+    }
+    *keyword_count = keywords;
+    return now_seconds() - start;
+}
+
+int main(int argc, char *argv[]) {
+    size_t size = 32u * 1024 * 1024;
+    if (argc > 1) {
+        size = strtoul(argv[1], NULL, 10);
+    }
+
+    size_t length;
+    char *source = generate_source(size, &length);
+    double mb = length / (1024.0 * 1024.0);
+
+    long legacy_keywords, keywords;
+    double legacy = time_classifier(source, length, legacy_check_keyword, &legacy_keywords);
+    double current = time_classifier(source, length, lookup_keyword, &keywords);
+
+    if (legacy_keywords != keywords) {
+        fprintf(stderr, "Mismatch: legacy found %ld keywords, lookup_keyword %ld\n",
+                legacy_keywords, keywords);
+        return 1;
+    }
+
+    double start = now_seconds();
+    int token_count = 0;
+    Token *tokens = tokenize(source, length, &token_count);
+    double lex = now_seconds() - start;
+    free(tokens);
+
+    printf("input: %.1f MB of identifiers (%ld keywords)\n", mb, keywords);
+    printf("%-28s %10.1f MB/s\n", "keywords, strcmp chain", mb / legacy);
+    printf("%-28s %10.1f MB/s\n", "keywords, lookup_keyword", mb / current);
+    printf("%-28s %10.1f MB/s\n", "tokenize", mb / lex);
+
+    free(source);
+    return 0;
+}
@@ -0,0 +1,70 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Startup benchmark: tokenize generated scripts from 1 KB up to 100 MB.
+// Time per byte should stay flat as the input grows.
+
+static const char *snippet =
+    "    set counter,0\n"
+    "    add counter,1 eq counter\n"
+    "    if counter lt 100\n"
+    "        echo \"counter is\" counter\n"
+    "    endb\n"
+    "    for i (1...10)\n"
+    "        mul i,2 eq doubled // comment\n"
+    "    endl\n";
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Build a script of roughly `size` bytes
+static char *generate_source(size_t size) {
+    size_t snippet_len = strlen(snippet);
+    char *source = malloc(size + snippet_len + 16);
+    size_t len = 0;
+
+    memcpy(source, "start .main\n", 12);
+    len = 12;
+    while (len < size) {
+        memcpy(source + len, snippet, snippet_len);
+        len += snippet_len;
+    }
+    source[len] = '\0';
+    return source;
+}
+
+int main(int argc, char *argv[]) {
+    size_t max_size = 100u * 1024 * 1024;
+    if (argc > 1) {
+        max_size = strtoul(argv[1], NULL, 10);
+    }
+
+    printf("%12s %12s %12s %10s %10s\n", "bytes", "tokens", "ms", "ns/byte", "MB/s");
+
+    for (size_t size = 1024; size <= max_size; size *= 10) {
+        char *source = generate_source(size);
+        size_t bytes = strlen(source);
+
+        double start = now_seconds();
+        int tokens = 0;
+        Token *stream = tokenize(source, bytes, &tokens);
+        double elapsed = now_seconds() - start;
+        free(stream);
+
+        printf("%12zu %12d %12.3f %10.2f %10.1f\n",
+               bytes, tokens, elapsed * 1e3,
+               elapsed * 1e9 / bytes, bytes / elapsed / (1024.0 * 1024.0));
+
+        free(source);
+    }
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "parser.h"
+#include "resolver.h"
+#include "compiler.h"
+#include "vm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Counted loop throughput: `for i (1...n)` from 1e3 up to 1e9 iterations
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Body never looks at i: the counter stays in its register
+static const char *hidden =
+    "start .main\n"
+    "    set n,0\n"
+    "    for i (1...%d)\n"
+    "        inc n\n"
+    "    endl\n";
+
+// Body reads i: the counter is copied out every iteration. It is
+// stored rather than summed so large n cannot overflow an int
+static const char *visible =
+    "start .main\n"
+    "    set s,0\n"
+    "    for i (1...%d)\n"
+    "        set s,i\n"
+    "    endl\n";
+
+static void run_case(const char *name, const char *template, int iterations) {
+    char source[1024];
+    int length = snprintf(source, sizeof(source), template, iterations);
+
+    Arena *arena = create_arena(64 * 1024);
+    ASTNode *program = parse_source(source, length, arena);
+    resolve(program, arena);
+    Proto *proto = compile(program);
+
+    double start = now_seconds();
+    vm_run(proto);
+    double elapsed = now_seconds() - start;
+
+    printf("%-10s %12d %10.1f %12.2f\n", name, iterations,
+           elapsed * 1e3, elapsed * 1e9 / iterations);
+
+    free_proto(proto);
+    free_arena(arena);
+}
+
+int main(int argc, char *argv[]) {
+    int limit = 1000000000;
+    if (argc > 1) {
+        limit = atoi(argv[1]);
+    }
+
+    printf("%-10s %12s %10s %12s\n", "case", "iterations", "ms", "ns/iter");
+    for (long long n = 1000; n <= limit; n *= 10) {
+        run_case("hidden", hidden, (int)n);
+        run_case("visible", visible, (int)n);
+    }
+
+    free_symbols();
+    return 0;
+}
@@ -0,0 +1,90 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "number.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Float formatting and parsing throughput in values/sec. The printf and
+// strtod rows are the previous "%f" and atof/strtod paths.
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Deterministic spread of magnitudes and digit counts
+static double sample(int i) {
+    unsigned int x = (unsigned int)i * 2654435761u;
+    double mantissa = (double)(x >> 8) / (1 << 24);
+    int scale = (int)(x % 24) - 8;
+    double value = mantissa;
+    while (scale > 0) { value *= 10; scale--; }
+    while (scale < 0) { value /= 10; scale++; }
+    return (i & 3) == 0 ? (double)(x % 1000) / 8 : value;
+}
+
+int main(int argc, char *argv[]) {
+    int count = 1000000;
+    if (argc > 1) {
+        count = atoi(argv[1]);
+    }
+
+    double *values = malloc(sizeof(double) * count);
+    char (*texts)[DOUBLE_TEXT_SIZE] = malloc(sizeof(*texts) * count);
+    for (int i = 0; i < count; i++) {
+        values[i] = sample(i);
+    }
+
+    char text[400];
+    size_t sink = 0;
+
+    double start = now_seconds();
+    for (int i = 0; i < count; i++) {
+        sink += snprintf(text, sizeof(text), "%f", values[i]);
+    }
+    double printf_f = now_seconds() - start;
+
+    start = now_seconds();
+    for (int i = 0; i < count; i++) {
+        sink += snprintf(text, sizeof(text), "%.17g", values[i]);
+    }
+    double printf_g = now_seconds() - start;
+
+    start = now_seconds();
+    for (int i = 0; i < count; i++) {
+        sink += format_double(values[i], texts[i]);
+    }
+    double format = now_seconds() - start;
+
+    double total = 0;
+    start = now_seconds();
+    for (int i = 0; i < count; i++) {
+        total += strtod(texts[i], NULL);
+    }
+    double strtod_time = now_seconds() - start;
+
+    int mismatches = 0;
+    start = now_seconds();
+    for (int i = 0; i < count; i++) {
+        size_t used;
+        double parsed = parse_double(texts[i], strlen(texts[i]), &used);
+        total += parsed;
+        if (parsed != values[i]) mismatches++;
+    }
+    double parse = now_seconds() - start;
+
+    printf("%-24s %12s %14s\n", "case", "values", "values/sec");
+    printf("%-24s %12d %14.0f\n", "printf %f (baseline)", count, count / printf_f);
+    printf("%-24s %12d %14.0f\n", "printf %.17g", count, count / printf_g);
+    printf("%-24s %12d %14.0f\n", "format_double", count, count / format);
+    printf("%-24s %12d %14.0f\n", "strtod (baseline)", count, count / strtod_time);
+    printf("%-24s %12d %14.0f\n", "parse_double", count, count / parse);
+    printf("round-trip mismatches: %d (checksum %zu %g)\n", mismatches, sink, total);
+
+    free(texts);
+    free(values);
+    return 0;
+}
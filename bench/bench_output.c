@@ -0,0 +1,97 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "parser.h"
+#include "resolver.h"
+#include "compiler.h"
+#include "vm.h"
+#include "output.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+// echo throughput in lines/sec with stdout sent to /dev/null. The stdio
+// row is the previous print_value + putchar path, kept as the baseline.
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const char *echo_ints =
+    "start .main\n"
+    "    for i (1...%d)\n"
+    "        echo i\n"
+    "    endl\n";
+
+static const char *echo_mixed =
+    "start .main\n"
+    "    set name,\"item\"\n"
+    "    for i (1...%d)\n"
+    "        echo name i true\n"
+    "    endl\n";
+
+static double run_program(const char *template, int lines) {
+    char source[1024];
+    int length = snprintf(source, sizeof(source), template, lines);
+
+    Arena *arena = create_arena(64 * 1024);
+    ASTNode *program = parse_source(source, length, arena);
+    resolve(program, arena);
+    Proto *proto = compile(program);
+
+    double start = now_seconds();
+    vm_run(proto);
+    double elapsed = now_seconds() - start;
+
+    free_proto(proto);
+    free_arena(arena);
+    return elapsed;
+}
+
+static double run_stdio(int lines) {
+    double start = now_seconds();
+    for (int i = 1; i <= lines; i++) {
+        print_value(int_value(i));
+        putchar('\n');
+    }
+    fflush(stdout);
+    return now_seconds() - start;
+}
+
+int main(int argc, char *argv[]) {
+    int lines = 10000000;
+    if (argc > 1) {
+        lines = atoi(argv[1]);
+    }
+
+    // Keep the real stdout for the report
+    fflush(stdout);
+    int report = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    close(null);
+
+    double stdio = run_stdio(lines);
+    double ints = run_program(echo_ints, lines);
+    double mixed = run_program(echo_mixed, lines);
+    output_set_unbuffered(1);
+    int unbuffered_lines = lines / 10;
+    double unbuffered = run_program(echo_ints, unbuffered_lines);
+
+    dup2(report, STDOUT_FILENO);
+    close(report);
+
+    printf("%-24s %12s %14s\n", "case", "lines", "lines/sec");
+    printf("%-24s %12d %14.0f\n", "stdio int (baseline)", lines, lines / stdio);
+    printf("%-24s %12d %14.0f\n", "echo int", lines, lines / ints);
+    printf("%-24s %12d %14.0f\n", "echo string int bool", lines, lines / mixed);
+    printf("%-24s %12d %14.0f\n", "echo int, --unbuffered", unbuffered_lines,
+           unbuffered_lines / unbuffered);
+
+    free_symbols();
+    return 0;
+}
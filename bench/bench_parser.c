@@ -0,0 +1,78 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Parser stress benchmark: very long blocks must parse with exact child
+// counts (no fixed capacities) in time linear in the statement count.
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Append to a growing source buffer
+static void append(char **buffer, size_t *length, size_t *capacity, const char *text) {
+    size_t len = strlen(text);
+    while (*length + len + 1 > *capacity) {
+        *capacity *= 2;
+        *buffer = realloc(*buffer, *capacity);
+    }
+    memcpy(*buffer + *length, text, len + 1);
+    *length += len;
+}
+
+// Build `loops` loops of `body` statements each, followed by `statements` statements
+static char *generate_source(int statements, int loops, int body, size_t *length) {
+    size_t capacity = 1024;
+    char *source = malloc(capacity);
+    *length = 0;
+    source[0] = '\0';
+
+    append(&source, length, &capacity, "start .main\n    set x,0\n");
+    for (int l = 0; l < loops; l++) {
+        append(&source, length, &capacity, "    for i (1...3)\n");
+        for (int b = 0; b < body; b++) {
+            append(&source, length, &capacity, "        add x,i eq x\n");
+        }
+        append(&source, length, &capacity, "    endl\n");
+    }
+    for (int s = 0; s < statements; s++) {
+        append(&source, length, &capacity, "    inc x\n");
+    }
+    return source;
+}
+
+static int run_case(const char *name, int statements, int loops, int body) {
+    size_t length;
+    char *source = generate_source(statements, loops, body, &length);
+
+    double start = now_seconds();
+    Arena *arena = create_arena(64 * 1024);
+    ASTNode *program = parse_source(source, length, arena);
+    double elapsed = now_seconds() - start;
+
+    int ok = program->data.program.statement_count == 1 + loops + statements;
+    for (int l = 0; ok && l < loops; l++) {
+        ASTNode *loop = program->data.program.statements[1 + l];
+        ok = loop->type == AST_FOR_LOOP && loop->data.for_loop.body_count == body;
+    }
+
+    printf("%-32s %10zu bytes %10.2f ms  %s\n", name, length, elapsed * 1e3, ok ? "ok" : "WRONG COUNT");
+
+    free_arena(arena);
+    free(source);
+    return ok;
+}
+
+int main(void) {
+    int ok = 1;
+    ok &= run_case("100k statements in main", 100000, 0, 0);
+    ok &= run_case("10 loops x 10k-statement bodies", 0, 10, 10000);
+    ok &= run_case("mixed", 100000, 10, 10000);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN alignof(max_align_t)
+
+// Allocate a new block and make it the head
+static ArenaBlock *push_block(Arena *arena, size_t min_size) {
+    size_t capacity = arena->block_size;
+    if (capacity < min_size) capacity = min_size;
+    
+    ArenaBlock *block = malloc(sizeof(ArenaBlock) + capacity);
+    block->next = arena->head;
+    block->used = 0;
+    block->capacity = capacity;
+    arena->head = block;
+    return block;
+}
+
+// Create arena
+Arena *create_arena(size_t block_size) {
+    Arena *arena = malloc(sizeof(Arena));
+    arena->head = NULL;
+    arena->block_size = block_size;
+    return arena;
+}
+
+// Free arena and everything allocated from it
+void free_arena(Arena *arena) {
+    if (!arena) return;
+    
+    ArenaBlock *block = arena->head;
+    while (block) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
+
+// Allocate memory by bumping the head block's offset
+void *arena_alloc(Arena *arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    
+    ArenaBlock *block = arena->head;
+    if (!block || block->capacity - block->used < size) {
+        block = push_block(arena, size);
+    }
+    
+    void *ptr = block->data + block->used;
+    block->used += size;
+    return ptr;
+}
+
+// Copy string slice
+char *arena_strndup(Arena *arena, const char *str, size_t length) {
+    char *copy = arena_alloc(arena, length + 1);
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    return copy;
+}
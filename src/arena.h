@@ -0,0 +1,32 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdalign.h>
+
+// Bump allocator: everything allocated from an arena is released together.
+// Used for the AST, its child arrays and identifier strings.
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t used;
+    size_t capacity;
+    alignas(max_align_t) char data[];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *head;        // Block currently being filled
+    size_t block_size;       // Default size for new blocks
+} Arena;
+
+// Create/destroy arena
+Arena *create_arena(size_t block_size);
+void free_arena(Arena *arena);
+
+// Allocate memory (aligned for any type, uninitialized)
+void *arena_alloc(Arena *arena, size_t size);
+
+// Copy a string slice into the arena (NUL-terminated)
+char *arena_strndup(Arena *arena, const char *str, size_t length);
+
+#endif
@@ -2,6 +2,8 @@
 #define AST_H
 
 #include "token.h"
+#include "arena.h"
+#include "symbol.h"
 
 // Node types
 typedef enum {
@@ -38,7 +40,15 @@ typedef enum {
 // Forward declaration
 typedef struct ASTNode ASTNode;
 
+// Variable reference: interned name plus the frame slot assigned by the resolver
+typedef struct {
+    int symbol;
+    int slot;
+} VarRef;
+
 // AST Node structure
+// Names (variables, labels, functions) are interned symbol IDs from symbol.h;
+// NO_SYMBOL marks an absent optional name.
 struct ASTNode {
     ASTNodeType type;
     int line;
@@ -49,40 +59,48 @@ struct ASTNode {
         struct {
             ASTNode **statements;
             int statement_count;
+            int slot_count;          // frame size of .main (set by resolver)
+            int site_count;          // binary operations in the program (set by resolver)
+            ASTNode **functions;     // AST_FUNCTION nodes by index (set by linker)
+            int function_count;
         } program;
         
         // Function definition
         struct {
-            char *name;              // .funcName
-            char **parameters;       // parameter names
+            int name;                // .funcName (symbol)
+            int *parameters;         // parameter symbols (slots 0..param_count-1)
             int param_count;
             ASTNode **body;          // function body statements
             int body_count;
+            int slot_count;          // frame size (set by resolver)
         } function;
         
         // Label
         struct {
-            char *name;              // .labelName
+            int name;                // .labelName (symbol)
+            ASTNode **block;         // statement list holding the label (set by resolver)
+            int index;               // its position there
         } label;
         
         // Assignment: set x,10 or set x eq 10
         struct {
-            char *variable;
+            VarRef variable;
             ASTNode *value;
         } assignment;
         
         // Binary operation: add x,y eq z
         struct {
             TokenType op;            // ADD, SUB, MUL, DIV, MOD, etc.
+            int site;                // number among the program's binary operations (set by resolver)
             ASTNode *left;
             ASTNode *right;
-            char *result;            // result variable (optional)
+            VarRef result;           // result variable (optional)
         } binary_op;
         
         // Unary operation: inc x, dec x
         struct {
             TokenType op;            // INC, DEC
-            char *variable;
+            VarRef variable;
             ASTNode *amount;         // optional: inc x,5
         } unary_op;
         
@@ -97,13 +115,13 @@ struct ASTNode {
         
         // For loop
         struct {
-            char *variable;
+            VarRef variable;
             ASTNode *start;
             ASTNode *end;
             ASTNode *step;           // optional
             ASTNode **body;
             int body_count;
-            char *label;             // optional: for i (1...10) _myloop
+            int label;               // optional: for i (1...10) _myloop
         } for_loop;
         
         // While loop
@@ -111,16 +129,19 @@ struct ASTNode {
             ASTNode *condition;
             ASTNode **body;
             int body_count;
-            char *label;             // optional
+            int label;               // optional
         } while_loop;
         
         // Function call: call .func(a,b) eq result
         struct {
-            char *function_name;
+            int function_name;       // symbol
+            int function;            // index into program.functions (set by linker)
             ASTNode **arguments;
             int arg_count;
-            char **result_vars;      // for multiple returns
+            int *result_vars;        // symbols, for multiple returns
+            int *result_slots;       // matching frame slots (set by resolver)
             int result_count;
+            int tail;                // followed by a ret of exactly its results (set by linker)
         } function_call;
         
         // Return statement
@@ -134,7 +155,8 @@ struct ASTNode {
             TokenType jump_type;     // JMP, JEQ, JNE, etc.
             ASTNode *left;           // for conditional jumps
             ASTNode *right;
-            char *target_label;
+            int target_label;        // symbol
+            ASTNode *target;         // AST_LABEL in the same frame (set by resolver)
         } jump;
         
         // Echo statement
@@ -145,7 +167,7 @@ struct ASTNode {
         
         // Break/Continue
         struct {
-            char *label;             // optional: break outer
+            int label;               // optional: break outer
         } break_continue;
         
         // Halt
@@ -155,20 +177,20 @@ struct ASTNode {
         
         // Type check: type x
         struct {
-            char *variable;
-            char *result_var;        // optional: type t eq x
+            VarRef variable;
+            VarRef result_var;       // optional: type t eq x
         } type_check;
         
         // Type cast: int x eq y
         struct {
             TokenType target_type;   // INT_CAST, FLOAT_CAST, etc.
             ASTNode *value;
-            char *result_var;
+            VarRef result_var;       // optional
         } type_cast;
         
         // Identifier
         struct {
-            char *name;
+            VarRef name;
         } identifier;
         
         // Literals
@@ -182,6 +204,7 @@ struct ASTNode {
         
         struct {
             char *value;
+            int length;              // the text may hold NUL bytes
         } string_literal;
         
         struct {
@@ -196,14 +219,14 @@ struct ASTNode {
         
         // Array access: arr[0]
         struct {
-            char *array_name;
+            VarRef array_name;
             ASTNode *index;
         } array_access;
         
         // Property access: arr.len
         struct {
-            char *object_name;
-            char *property;
+            VarRef object_name;
+            int property;            // symbol
         } property_access;
         
         // Input: $
@@ -213,9 +236,8 @@ struct ASTNode {
     } data;
 };
 
-// Create AST nodes
-ASTNode *create_ast_node(ASTNodeType type, int line, int column);
-void free_ast_node(ASTNode *node);
+// Create AST nodes (freed all at once with the arena)
+ASTNode *create_ast_node(Arena *arena, ASTNodeType type, int line, int column);
 void print_ast(ASTNode *node, int indent);
 
 #endif
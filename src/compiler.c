@@ -0,0 +1,898 @@
+#include "compiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+// Loop being compiled; break/continue jumps are chained through their
+// target field until the destination is known
+typedef struct Loop {
+    int label;               // NO_SYMBOL if the loop is unnamed
+    int break_chain;
+    int continue_chain;
+    struct Loop *enclosing;
+} Loop;
+
+// Jump to a label, patched once the frame is compiled (labels can follow
+// the jumps that target them)
+typedef struct {
+    int pc;
+    int label;               // symbol
+} JumpFixup;
+
+typedef struct {
+    Proto *proto;
+    int code_capacity;
+    int constant_capacity;
+    int call_capacity;
+    int next_register;       // first free temporary
+    Loop *loop;
+    Proto **functions;       // callee by linked function index
+    int *label_pc;           // label symbol -> pc of its code in this frame
+    JumpFixup *fixups;
+    int fixup_count;
+    int fixup_capacity;
+} Compiler;
+
+// ==================== EMITTING ====================
+
+static int emit(Compiler *c, int op, int a, int b, int arg) {
+    Proto *proto = c->proto;
+    if (proto->code_count == c->code_capacity) {
+        c->code_capacity *= 2;
+        proto->code = realloc(proto->code, sizeof(Instr) * c->code_capacity);
+    }
+    Instr *instr = &proto->code[proto->code_count];
+    instr->op = op;
+    instr->a = a;
+    instr->b = b;
+    instr->c = arg;
+    return proto->code_count++;
+}
+
+static int add_constant(Compiler *c, Value value) {
+    Proto *proto = c->proto;
+    if (proto->constant_count == c->constant_capacity) {
+        c->constant_capacity *= 2;
+        proto->constants = realloc(proto->constants, sizeof(Value) * c->constant_capacity);
+    }
+    proto->constants[proto->constant_count] = value;
+    return proto->constant_count++;
+}
+
+static int add_call(Compiler *c, CallSite site) {
+    Proto *proto = c->proto;
+    if (proto->call_count == c->call_capacity) {
+        c->call_capacity = c->call_capacity ? c->call_capacity * 2 : 8;
+        proto->calls = realloc(proto->calls, sizeof(CallSite) * c->call_capacity);
+    }
+    proto->calls[proto->call_count] = site;
+    return proto->call_count++;
+}
+
+static int current_pc(Compiler *c) {
+    return c->proto->code_count;
+}
+
+// Point every jump on a chain at target
+static void patch_chain(Compiler *c, int chain, int target) {
+    while (chain >= 0) {
+        Instr *instr = &c->proto->code[chain];
+        int next = instr->a;
+        instr->a = target;
+        chain = next;
+    }
+}
+
+// ==================== REGISTERS ====================
+
+static int alloc_register(Compiler *c) {
+    int reg = c->next_register++;
+    if (c->next_register > c->proto->register_count) {
+        c->proto->register_count = c->next_register;
+    }
+    return reg;
+}
+
+static int slot_register(Compiler *c, VarRef var) {
+    c->proto->slot_names[var.slot] = var.symbol;
+    return var.slot;
+}
+
+static void compile_error(ASTNode *node, const char *message) {
+    fprintf(stderr, "Compile Error [%d:%d]: %s\n", node->line, node->column, message);
+    exit(1);
+}
+
+// ==================== EXPRESSIONS ====================
+
+static void compile_statement(Compiler *c, ASTNode *node);
+
+static int binary_opcode(TokenType op) {
+    switch (op) {
+        case TOKEN_ADD: return OP_ADD;
+        case TOKEN_SUB: return OP_SUB;
+        case TOKEN_MUL: return OP_MUL;
+        case TOKEN_DIV: return OP_DIV;
+        case TOKEN_MOD: return OP_MOD;
+        case TOKEN_EQ: return OP_EQ;
+        case TOKEN_NE: return OP_NE;
+        case TOKEN_GT: return OP_GT;
+        case TOKEN_LT: return OP_LT;
+        case TOKEN_GE: return OP_GE;
+        case TOKEN_LE: return OP_LE;
+        case TOKEN_AND: return OP_AND;
+        case TOKEN_OR: return OP_OR;
+        case TOKEN_CONCAT: return OP_CONCAT;
+        default: return -1;
+    }
+}
+
+static int is_arithmetic(int op) {
+    return op >= OP_ADD && op <= OP_MOD;
+}
+
+// Compile an expression and return the register holding its value.
+// With dest >= 0 the value is placed in dest; otherwise variables are
+// used in place and anything else lands in a fresh temporary.
+static int compile_expression(Compiler *c, ASTNode *node, int dest) {
+    int saved = c->next_register;
+    int target;
+    
+    switch (node->type) {
+        case AST_IDENTIFIER: {
+            int slot = slot_register(c, node->data.identifier.name);
+            if (dest < 0) return slot;
+            emit(c, OP_MOVE, dest, slot, 0);
+            return dest;
+        }
+        
+        case AST_LITERAL_INT:
+        case AST_LITERAL_FLOAT:
+        case AST_LITERAL_STRING:
+        case AST_LITERAL_BOOL: {
+            Value k;
+            if (node->type == AST_LITERAL_INT) {
+                k = int_value(node->data.int_literal.value);
+            } else if (node->type == AST_LITERAL_FLOAT) {
+                k = float_value(node->data.float_literal.value);
+            } else if (node->type == AST_LITERAL_STRING) {
+                k = string_value_n(node->data.string_literal.value,
+                                   node->data.string_literal.length);
+            } else {
+                k = bool_value(node->data.bool_literal.value);
+            }
+            target = dest >= 0 ? dest : alloc_register(c);
+            emit(c, OP_LOADK, target, add_constant(c, k), 0);
+            return target;
+        }
+        
+        case AST_BINARY_OP: {
+            int op = binary_opcode(node->data.binary_op.op);
+            VarRef result = node->data.binary_op.result;
+            int has_result = (result.symbol != NO_SYMBOL);
+            
+            target = has_result ? slot_register(c, result) : (dest >= 0 ? dest : alloc_register(c));
+            int left = compile_expression(c, node->data.binary_op.left, -1);
+            int right = compile_expression(c, node->data.binary_op.right, -1);
+            
+            // Arithmetic skips its store on a type mismatch, so a temporary
+            // target must not keep a stale value
+            if (!has_result && is_arithmetic(op)) {
+                emit(c, OP_LOADNULL, target, 0, 0);
+            }
+            emit(c, op, target, left, right);
+            c->next_register = saved > target ? saved : target + 1;
+            
+            if (has_result && dest >= 0 && dest != target) {
+                emit(c, OP_MOVE, dest, target, 0);
+                return dest;
+            }
+            return target;
+        }
+        
+        case AST_ARRAY: {
+            int count = node->data.array.element_count;
+            target = dest >= 0 ? dest : alloc_register(c);
+            int base = c->next_register;
+            for (int i = 0; i < count; i++) {
+                alloc_register(c);
+            }
+            for (int i = 0; i < count; i++) {
+                compile_expression(c, node->data.array.elements[i], base + i);
+            }
+            emit(c, OP_ARRAY, target, base, count);
+            c->next_register = saved > target ? saved : target + 1;
+            return target;
+        }
+        
+        case AST_ARRAY_ACCESS: {
+            target = dest >= 0 ? dest : alloc_register(c);
+            int array = slot_register(c, node->data.array_access.array_name);
+            int index = compile_expression(c, node->data.array_access.index, -1);
+            emit(c, OP_INDEX, target, array, index);
+            c->next_register = saved > target ? saved : target + 1;
+            return target;
+        }
+        
+        case AST_TYPE_CAST: {
+            VarRef result = node->data.type_cast.result_var;
+            int has_result = (result.symbol != NO_SYMBOL);
+            
+            target = has_result ? slot_register(c, result) : (dest >= 0 ? dest : alloc_register(c));
+            int value = compile_expression(c, node->data.type_cast.value, -1);
+            emit(c, OP_CAST, target, value, cast_target(node->data.type_cast.target_type));
+            c->next_register = saved > target ? saved : target + 1;
+            
+            if (has_result && dest >= 0 && dest != target) {
+                emit(c, OP_MOVE, dest, target, 0);
+                return dest;
+            }
+            return target;
+        }
+        
+        default:
+            // Statements and not-yet-supported expressions evaluate to null
+            compile_statement(c, node);
+            target = dest >= 0 ? dest : alloc_register(c);
+            emit(c, OP_LOADNULL, target, 0, 0);
+            return target;
+    }
+}
+
+// ==================== STATEMENTS ====================
+
+static void compile_block(Compiler *c, ASTNode **body, int count) {
+    for (int i = 0; i < count; i++) {
+        compile_statement(c, body[i]);
+    }
+}
+
+static void compile_if(Compiler *c, ASTNode *node) {
+    int saved = c->next_register;
+    int cond = compile_expression(c, node->data.if_stmt.condition, -1);
+    c->next_register = saved;
+    
+    int jump_else = emit(c, OP_JMPF, cond, -1, 0);
+    compile_block(c, node->data.if_stmt.then_body, node->data.if_stmt.then_count);
+    
+    if (node->data.if_stmt.else_count > 0) {
+        int jump_end = emit(c, OP_JMP, -1, 0, 0);
+        c->proto->code[jump_else].b = current_pc(c);
+        compile_block(c, node->data.if_stmt.else_body, node->data.if_stmt.else_count);
+        c->proto->code[jump_end].a = current_pc(c);
+    } else {
+        c->proto->code[jump_else].b = current_pc(c);
+    }
+}
+
+static void begin_loop(Compiler *c, Loop *loop, int label) {
+    loop->label = label;
+    loop->break_chain = -1;
+    loop->continue_chain = -1;
+    loop->enclosing = c->loop;
+    c->loop = loop;
+}
+
+static void end_loop(Compiler *c, Loop *loop, int exit) {
+    patch_chain(c, loop->break_chain, exit);
+    c->loop = loop->enclosing;
+}
+
+// Can anything in a loop body see the loop variable before the loop ends?
+// True if the body reads or writes the variable's slot, or if control can
+// leave or enter the body other than through the loop itself (jumps,
+// labels, labelled break/continue).
+static int observes_slot(ASTNode *node, int slot);
+
+static int block_observes_slot(ASTNode **body, int count, int slot) {
+    for (int i = 0; i < count; i++) {
+        if (observes_slot(body[i], slot)) return 1;
+    }
+    return 0;
+}
+
+static int observes_slot(ASTNode *node, int slot) {
+    if (!node) return 0;
+    
+    switch (node->type) {
+        case AST_LABEL:
+        case AST_JUMP:
+            return 1;
+        
+        case AST_BREAK:
+        case AST_CONTINUE:
+            return node->data.break_continue.label != NO_SYMBOL;
+        
+        case AST_ASSIGNMENT:
+            return node->data.assignment.variable.slot == slot ||
+                   observes_slot(node->data.assignment.value, slot);
+        
+        case AST_BINARY_OP:
+            return node->data.binary_op.result.slot == slot ||
+                   observes_slot(node->data.binary_op.left, slot) ||
+                   observes_slot(node->data.binary_op.right, slot);
+        
+        case AST_UNARY_OP:
+            return node->data.unary_op.variable.slot == slot ||
+                   observes_slot(node->data.unary_op.amount, slot);
+        
+        case AST_IF_STATEMENT:
+            return observes_slot(node->data.if_stmt.condition, slot) ||
+                   block_observes_slot(node->data.if_stmt.then_body, node->data.if_stmt.then_count, slot) ||
+                   block_observes_slot(node->data.if_stmt.else_body, node->data.if_stmt.else_count, slot);
+        
+        case AST_FOR_LOOP:
+            return node->data.for_loop.variable.slot == slot ||
+                   observes_slot(node->data.for_loop.start, slot) ||
+                   observes_slot(node->data.for_loop.end, slot) ||
+                   observes_slot(node->data.for_loop.step, slot) ||
+                   block_observes_slot(node->data.for_loop.body, node->data.for_loop.body_count, slot);
+        
+        case AST_WHILE_LOOP:
+            return observes_slot(node->data.while_loop.condition, slot) ||
+                   block_observes_slot(node->data.while_loop.body, node->data.while_loop.body_count, slot);
+        
+        case AST_FUNCTION_CALL:
+            for (int i = 0; i < node->data.function_call.result_count; i++) {
+                if (node->data.function_call.result_slots[i] == slot) return 1;
+            }
+            return block_observes_slot(node->data.function_call.arguments, node->data.function_call.arg_count, slot);
+        
+        case AST_RETURN:
+            return block_observes_slot(node->data.return_stmt.values, node->data.return_stmt.value_count, slot);
+        
+        case AST_ECHO:
+            return block_observes_slot(node->data.echo.expressions, node->data.echo.expr_count, slot);
+        
+        case AST_HALT:
+            return observes_slot(node->data.halt.message, slot);
+        
+        case AST_TYPE_CHECK:
+            return node->data.type_check.variable.slot == slot ||
+                   node->data.type_check.result_var.slot == slot;
+        
+        case AST_TYPE_CAST:
+            return node->data.type_cast.result_var.slot == slot ||
+                   observes_slot(node->data.type_cast.value, slot);
+        
+        case AST_IDENTIFIER:
+            return node->data.identifier.name.slot == slot;
+        
+        case AST_ARRAY:
+            return block_observes_slot(node->data.array.elements, node->data.array.element_count, slot);
+        
+        case AST_ARRAY_ACCESS:
+            return node->data.array_access.array_name.slot == slot ||
+                   observes_slot(node->data.array_access.index, slot);
+        
+        case AST_PROPERTY_ACCESS:
+            return node->data.property_access.object_name.slot == slot;
+        
+        case AST_INPUT:
+            return observes_slot(node->data.input.prompt, slot);
+        
+        default:
+            return 0;
+    }
+}
+
+// Counted loops are rotated: FORPREP checks the range once and skips the
+// loop on a type error, the body runs, and FORLOOP steps the hidden counter
+// and branches back while it is in range. The counter lives in a register;
+// FORPREP/FORLOOP write it to the loop variable each iteration only when the
+// body can observe the variable, otherwise it is copied once after the loop.
+static void compile_for(Compiler *c, ASTNode *node) {
+    int saved = c->next_register;
+    
+    // Hidden loop state: counter, end, step (becomes the signed delta), direction
+    int base = alloc_register(c);
+    alloc_register(c);
+    alloc_register(c);
+    alloc_register(c);
+    
+    compile_expression(c, node->data.for_loop.start, base);
+    compile_expression(c, node->data.for_loop.end, base + 1);
+    if (node->data.for_loop.step) {
+        compile_expression(c, node->data.for_loop.step, base + 2);
+    } else {
+        emit(c, OP_LOADK, base + 2, add_constant(c, int_value(1)), 0);
+    }
+    
+    int var = slot_register(c, node->data.for_loop.variable);
+    int observed = block_observes_slot(node->data.for_loop.body, node->data.for_loop.body_count,
+                                       node->data.for_loop.variable.slot);
+    
+    int prep = emit(c, OP_FORPREP, base, -1, observed ? var : -1);
+    int body = current_pc(c);
+    
+    Loop loop;
+    begin_loop(c, &loop, node->data.for_loop.label);
+    compile_block(c, node->data.for_loop.body, node->data.for_loop.body_count);
+    patch_chain(c, loop.continue_chain, current_pc(c));
+    emit(c, OP_FORLOOP, base, body, observed ? var : -1);
+    
+    end_loop(c, &loop, current_pc(c));
+    if (!observed) {
+        emit(c, OP_MOVE, var, base, 0);
+    }
+    c->proto->code[prep].b = current_pc(c);
+    
+    c->next_register = saved;
+}
+
+static void compile_while(Compiler *c, ASTNode *node) {
+    int saved = c->next_register;
+    int head = current_pc(c);
+    int cond = compile_expression(c, node->data.while_loop.condition, -1);
+    c->next_register = saved;
+    int jump_exit = emit(c, OP_JMPF, cond, -1, 0);
+    
+    Loop loop;
+    begin_loop(c, &loop, node->data.while_loop.label);
+    compile_block(c, node->data.while_loop.body, node->data.while_loop.body_count);
+    emit(c, OP_JMP, head, 0, 0);
+    patch_chain(c, loop.continue_chain, head);
+    
+    int exit = current_pc(c);
+    c->proto->code[jump_exit].b = exit;
+    end_loop(c, &loop, exit);
+}
+
+static void compile_break_continue(Compiler *c, ASTNode *node) {
+    int label = node->data.break_continue.label;
+    Loop *loop = c->loop;
+    while (loop && label != NO_SYMBOL && loop->label != label) {
+        loop = loop->enclosing;
+    }
+    if (!loop) {
+        compile_error(node, label != NO_SYMBOL ? "No enclosing loop with that label"
+                                               : "break/continue outside of a loop");
+    }
+    
+    int *chain = (node->type == AST_BREAK) ? &loop->break_chain : &loop->continue_chain;
+    *chain = emit(c, OP_JMP, *chain, 0, 0);
+}
+
+static void compile_call(Compiler *c, ASTNode *node) {
+    int arg_count = node->data.function_call.arg_count;
+    int result_count = node->data.function_call.result_count;
+    
+    CallSite site;
+    site.name = node->data.function_call.function_name;
+    site.callee = c->functions[node->data.function_call.function];
+    site.arg_count = arg_count;
+    site.result_count = result_count;
+    site.args = malloc(sizeof(int) * (arg_count > 0 ? arg_count : 1));
+    site.results = malloc(sizeof(int) * (result_count > 0 ? result_count : 1));
+    
+    // Variables are passed from their own registers; the temporaries
+    // holding other arguments stay live until the call
+    for (int i = 0; i < arg_count; i++) {
+        site.args[i] = compile_expression(c, node->data.function_call.arguments[i], -1);
+    }
+    for (int i = 0; i < result_count; i++) {
+        VarRef result = { node->data.function_call.result_vars[i],
+                          node->data.function_call.result_slots[i] };
+        site.results[i] = slot_register(c, result);
+    }
+    
+    // The linker only marks calls inside functions as tail calls
+    emit(c, node->data.function_call.tail ? OP_TAILCALL : OP_CALL, add_call(c, site), 0, 0);
+}
+
+static void compile_return(Compiler *c, ASTNode *node) {
+    int count = node->data.return_stmt.value_count;
+    int base = c->next_register;
+    for (int i = 0; i < count; i++) {
+        alloc_register(c);
+    }
+    for (int i = 0; i < count; i++) {
+        compile_expression(c, node->data.return_stmt.values[i], base + i);
+    }
+    
+    // In .main ret ends the program
+    emit(c, c->proto->name != NO_SYMBOL ? OP_RET : OP_END, base, count, 0);
+}
+
+// jmp .L -> JMP L;  jlt x,y .L -> JMP_LT x,y,L (taken only when the
+// comparison holds, so incomparable operands fall through)
+static void compile_jump(Compiler *c, ASTNode *node) {
+    int pc;
+    TokenType type = node->data.jump.jump_type;
+    if (type == TOKEN_JMP) {
+        pc = emit(c, OP_JMP, -1, 0, 0);
+    } else {
+        int left = compile_expression(c, node->data.jump.left, -1);
+        int right = compile_expression(c, node->data.jump.right, -1);
+        pc = emit(c, OP_JMP_EQ + (type - TOKEN_JEQ), left, right, -1);
+    }
+    
+    if (c->fixup_count == c->fixup_capacity) {
+        c->fixup_capacity = c->fixup_capacity ? c->fixup_capacity * 2 : 16;
+        c->fixups = realloc(c->fixups, sizeof(JumpFixup) * c->fixup_capacity);
+    }
+    c->fixups[c->fixup_count++] = (JumpFixup){ pc, node->data.jump.target->data.label.name };
+}
+
+static int *jump_target(Instr *instr);
+
+// Point every jump at its label's code
+static void patch_jumps(Compiler *c) {
+    for (int i = 0; i < c->fixup_count; i++) {
+        JumpFixup *fixup = &c->fixups[i];
+        *jump_target(&c->proto->code[fixup->pc]) = c->label_pc[fixup->label];
+    }
+}
+
+static void compile_statement(Compiler *c, ASTNode *node) {
+    int saved = c->next_register;
+    
+    switch (node->type) {
+        case AST_ASSIGNMENT:
+            compile_expression(c, node->data.assignment.value,
+                               slot_register(c, node->data.assignment.variable));
+            break;
+        
+        case AST_BINARY_OP:
+        case AST_IDENTIFIER:
+        case AST_LITERAL_INT:
+        case AST_LITERAL_FLOAT:
+        case AST_LITERAL_STRING:
+        case AST_LITERAL_BOOL:
+        case AST_ARRAY:
+        case AST_ARRAY_ACCESS:
+        case AST_TYPE_CAST:
+            compile_expression(c, node, -1);
+            break;
+        
+        case AST_UNARY_OP: {
+            int var = slot_register(c, node->data.unary_op.variable);
+            int amount;
+            if (node->data.unary_op.amount) {
+                amount = compile_expression(c, node->data.unary_op.amount, -1);
+            } else {
+                amount = alloc_register(c);
+                emit(c, OP_LOADK, amount, add_constant(c, int_value(1)), 0);
+            }
+            emit(c, node->data.unary_op.op == TOKEN_INC ? OP_INC : OP_DEC, var, amount, 0);
+            break;
+        }
+        
+        case AST_ECHO: {
+            int count = node->data.echo.expr_count;
+            for (int i = 0; i < count; i++) {
+                int reg = compile_expression(c, node->data.echo.expressions[i], -1);
+                emit(c, OP_ECHO, reg, 0, i == count - 1);
+                c->next_register = saved;
+            }
+            if (count == 0) {
+                emit(c, OP_ECHO, -1, 0, 1);
+            }
+            break;
+        }
+        
+        case AST_IF_STATEMENT:
+            compile_if(c, node);
+            break;
+        
+        case AST_FOR_LOOP:
+            compile_for(c, node);
+            break;
+        
+        case AST_WHILE_LOOP:
+            compile_while(c, node);
+            break;
+        
+        case AST_BREAK:
+        case AST_CONTINUE:
+            compile_break_continue(c, node);
+            break;
+        
+        case AST_FUNCTION_CALL:
+            compile_call(c, node);
+            break;
+        
+        case AST_RETURN:
+            compile_return(c, node);
+            break;
+        
+        case AST_LABEL:
+            c->label_pc[node->data.label.name] = current_pc(c);
+            break;
+        
+        case AST_JUMP:
+            compile_jump(c, node);
+            break;
+        
+        case AST_HALT: {
+            int reg = -1;
+            if (node->data.halt.message) {
+                reg = compile_expression(c, node->data.halt.message, -1);
+            }
+            emit(c, OP_HALT, reg, 0, 0);
+            break;
+        }
+        
+        default:
+            emit(c, OP_UNIMPLEMENTED, node->type, 0, 0);
+            break;
+    }
+    
+    c->next_register = saved;
+}
+
+// ==================== PEEPHOLE ====================
+
+// Field holding an instruction's jump target, or NULL if it doesn't jump
+static int *jump_target(Instr *instr) {
+    switch (instr->op) {
+        case OP_JMP:
+            return &instr->a;
+        case OP_JMPF:
+        case OP_FORPREP:
+        case OP_FORLOOP:
+            return &instr->b;
+        default:
+            if ((instr->op >= OP_JMP_EQ && instr->op <= OP_JMP_LE) ||
+                (instr->op >= OP_JMPF_EQ && instr->op <= OP_JMP_LEK)) {
+                return &instr->c;
+            }
+            return NULL;
+    }
+}
+
+static int is_temporary(Proto *proto, int reg) {
+    return reg >= proto->slot_count;
+}
+
+// Does instr load a small int constant into a temporary?
+static int loads_int_constant(Proto *proto, Instr *instr) {
+    return instr->op == OP_LOADK && is_temporary(proto, instr->a) &&
+           proto->constants[instr->b].type == VAL_INT;
+}
+
+// Fuse common instruction pairs and triples into superinstructions:
+//   LOADK t,K ; INC x,t              -> INCK x,K
+//   LOADK t,K ; ADD z,x,t            -> ADDK z,x,K      (also SUB, MUL)
+//   LT t,x,y ; JMPF t,L              -> JMPF_LT x,y,L   (every comparison)
+//   LOADK k,K ; LT t,x,k ; JMPF t,L  -> JMPF_LTK x,K,L
+//   LOADK k,K ; JMP_LT x,k,L         -> JMP_LTK x,K,L
+// Instructions that are jump targets are only ever the first of a group.
+static void peephole(Proto *proto) {
+    int count = proto->code_count;
+    Instr *code = proto->code;
+    
+    char *is_target = calloc(count + 1, 1);
+    for (int i = 0; i < count; i++) {
+        int *target = jump_target(&code[i]);
+        if (target) is_target[*target] = 1;
+    }
+    
+    for (int i = 0; i + 1 < count; i++) {
+        Instr *first = &code[i];
+        Instr *second = &code[i + 1];
+        if (is_target[i + 1]) continue;
+        
+        if (loads_int_constant(proto, first)) {
+            int k = proto->constants[first->b].data.int_val;
+            int t = first->a;
+            
+            if ((second->op == OP_INC || second->op == OP_DEC) && second->b == t && k != INT_MIN) {
+                second->c = (second->op == OP_DEC);
+                second->b = second->c ? -k : k;
+                second->op = OP_INCK;
+                first->op = OP_NOP;
+            } else if ((second->op == OP_ADD || second->op == OP_SUB || second->op == OP_MUL) &&
+                       second->c == t && second->b != t) {
+                second->op = OP_ADDK + (second->op - OP_ADD);
+                second->c = k;
+                first->op = OP_NOP;
+            } else if (second->op >= OP_EQ && second->op <= OP_LE && second->c == t &&
+                       second->b != t && i + 2 < count && !is_target[i + 2] &&
+                       code[i + 2].op == OP_JMPF && code[i + 2].a == second->a &&
+                       is_temporary(proto, second->a)) {
+                Instr *branch = &code[i + 2];
+                branch->op = OP_JMPF_EQK + (second->op - OP_EQ);
+                branch->c = branch->b;
+                branch->a = second->b;
+                branch->b = k;
+                first->op = OP_NOP;
+                second->op = OP_NOP;
+            } else if (second->op >= OP_JMP_EQ && second->op <= OP_JMP_LE &&
+                       second->b == t && second->a != t) {
+                second->op = OP_JMP_EQK + (second->op - OP_JMP_EQ);
+                second->b = k;
+                first->op = OP_NOP;
+            }
+            continue;
+        }
+        
+        if (first->op >= OP_EQ && first->op <= OP_LE && second->op == OP_JMPF &&
+            second->a == first->a && is_temporary(proto, first->a)) {
+            second->op = OP_JMPF_EQ + (first->op - OP_EQ);
+            second->c = second->b;
+            second->a = first->b;
+            second->b = first->c;
+            first->op = OP_NOP;
+        }
+    }
+    
+    // Compact, then point jumps at the new positions
+    int *new_pc = malloc(sizeof(int) * (count + 1));
+    int out = 0;
+    for (int i = 0; i < count; i++) {
+        new_pc[i] = out;
+        if (code[i].op != OP_NOP) {
+            code[out++] = code[i];
+        }
+    }
+    new_pc[count] = out;
+    
+    for (int i = 0; i < out; i++) {
+        int *target = jump_target(&code[i]);
+        if (target) *target = new_pc[*target];
+    }
+    proto->code_count = out;
+    
+    free(new_pc);
+    free(is_target);
+}
+
+// ==================== ENTRY POINTS ====================
+
+static Proto *new_proto(int name, int param_count, int slot_count) {
+    Proto *proto = malloc(sizeof(Proto));
+    proto->code = malloc(sizeof(Instr) * 256);
+    proto->code_count = 0;
+    proto->constants = malloc(sizeof(Value) * 64);
+    proto->constant_count = 0;
+    proto->name = name;
+    proto->param_count = param_count;
+    proto->slot_count = slot_count;
+    proto->register_count = slot_count;
+    // Temporaries are named lazily, so the table grows after compiling
+    proto->slot_names = calloc(slot_count > 0 ? slot_count : 1, sizeof(int));
+    proto->calls = NULL;
+    proto->call_count = 0;
+    proto->functions = NULL;
+    proto->function_count = 0;
+    proto->threaded = NULL;
+    proto->site_runs = NULL;
+    return proto;
+}
+
+// Compile one frame's statements (function definitions are skipped)
+static void compile_frame(Proto *proto, Proto **functions, int *label_pc,
+                          ASTNode **body, int count, int end_op) {
+    int slot_count = proto->slot_count;
+    
+    Compiler c;
+    c.proto = proto;
+    c.code_capacity = 256;
+    c.constant_capacity = 64;
+    c.call_capacity = 0;
+    c.next_register = slot_count;
+    c.loop = NULL;
+    c.functions = functions;
+    c.label_pc = label_pc;
+    c.fixups = NULL;
+    c.fixup_count = 0;
+    c.fixup_capacity = 0;
+    
+    for (int i = 0; i < count; i++) {
+        if (body[i]->type != AST_FUNCTION) {
+            compile_statement(&c, body[i]);
+        }
+    }
+    emit(&c, end_op, 0, 0, 0);
+    patch_jumps(&c);
+    free(c.fixups);
+    peephole(proto);
+    
+    proto->slot_names = realloc(proto->slot_names, sizeof(int) * (proto->register_count + 1));
+    for (int i = slot_count; i < proto->register_count; i++) {
+        proto->slot_names[i] = NO_SYMBOL;
+    }
+}
+
+Proto *compile(ASTNode *program) {
+    ASTNode **functions = program->data.program.functions;
+    int function_count = program->data.program.function_count;
+    
+    Proto *entry = new_proto(NO_SYMBOL, 0, program->data.program.slot_count);
+    
+    // Create every function first so calls can point at their callee
+    // before it is compiled
+    entry->functions = malloc(sizeof(Proto*) * (function_count > 0 ? function_count : 1));
+    entry->function_count = function_count;
+    for (int i = 0; i < function_count; i++) {
+        ASTNode *func = functions[i];
+        Proto *proto = new_proto(func->data.function.name, func->data.function.param_count,
+                                 func->data.function.slot_count);
+        for (int p = 0; p < proto->param_count; p++) {
+            proto->slot_names[p] = func->data.function.parameters[p];
+        }
+        entry->functions[i] = proto;
+    }
+    
+    // The resolver keeps every jump inside its frame, so one table serves
+    // all frames: a label's entry is set before the frame's jumps are patched
+    int *label_pc = malloc(sizeof(int) * (symbol_count() + 1));
+    
+    compile_frame(entry, entry->functions, label_pc, program->data.program.statements,
+                  program->data.program.statement_count, OP_END);
+    
+    // Falling off the end of a function returns nothing
+    for (int i = 0; i < function_count; i++) {
+        compile_frame(entry->functions[i], entry->functions, label_pc,
+                      functions[i]->data.function.body, functions[i]->data.function.body_count, OP_RET);
+    }
+    
+    free(label_pc);
+    return entry;
+}
+
+void free_proto(Proto *proto) {
+    if (!proto) return;
+    
+    for (int i = 0; i < proto->function_count; i++) {
+        free_proto(proto->functions[i]);
+    }
+    free(proto->functions);
+    for (int i = 0; i < proto->call_count; i++) {
+        free(proto->calls[i].args);
+        free(proto->calls[i].results);
+    }
+    free(proto->calls);
+    for (int i = 0; i < proto->constant_count; i++) {
+        release_value(proto->constants[i]);
+    }
+    free(proto->constants);
+    free(proto->code);
+    free(proto->slot_names);
+    free(proto);
+}
+
+// ==================== DEBUG ====================
+
+const char *opcode_name(int op) {
+    static const char *names[] = {
+        "LOADK", "LOADNULL", "MOVE",
+        "ADD", "SUB", "MUL", "DIV", "MOD",
+        "EQ", "NE", "GT", "LT", "GE", "LE", "AND", "OR", "CONCAT",
+        "INC", "DEC",
+        "ARRAY", "INDEX", "CAST", "ECHO",
+        "JMP", "JMPF",
+        "JMP_EQ", "JMP_NE", "JMP_GT", "JMP_LT", "JMP_GE", "JMP_LE",
+        "FORPREP", "FORLOOP",
+        "CALL", "TAILCALL", "RET",
+        "ADDK", "SUBK", "MULK", "INCK",
+        "JMPF_EQ", "JMPF_NE", "JMPF_GT", "JMPF_LT", "JMPF_GE", "JMPF_LE",
+        "JMPF_EQK", "JMPF_NEK", "JMPF_GTK", "JMPF_LTK", "JMPF_GEK", "JMPF_LEK",
+        "JMP_EQK", "JMP_NEK", "JMP_GTK", "JMP_LTK", "JMP_GEK", "JMP_LEK",
+        "HALT", "UNIMPLEMENTED", "END", "NOP"
+    };
+    if (op < 0 || op > OP_NOP) return "UNKNOWN";
+    return names[op];
+}
+
+void print_proto(Proto *proto) {
+    printf("; %s: %d slots, %d registers, %d constants\n",
+           proto->name != NO_SYMBOL ? symbol_name(proto->name) : ".main",
+           proto->slot_count, proto->register_count, proto->constant_count);
+    for (int i = 0; i < proto->code_count; i++) {
+        Instr *instr = &proto->code[i];
+        printf("%4d  %-14s %4d %4d %4d", i, opcode_name(instr->op), instr->a, instr->b, instr->c);
+        if (instr->op == OP_LOADK) {
+            printf("    ; ");
+            print_value(proto->constants[instr->b]);
+        } else if (instr->op == OP_CALL || instr->op == OP_TAILCALL) {
+            printf("    ; %s", symbol_name(proto->calls[instr->a].name));
+        }
+        printf("\n");
+    }
+    for (int i = 0; i < proto->function_count; i++) {
+        printf("\n");
+        print_proto(proto->functions[i]);
+    }
+}
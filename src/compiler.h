@@ -0,0 +1,130 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "ast.h"
+#include "value.h"
+
+// Register-machine opcodes. Registers are the resolver's frame slots
+// followed by compiler temporaries; a, b, c name registers unless noted.
+typedef enum {
+    OP_LOADK,            // R[a] = K[b]
+    OP_LOADNULL,         // R[a] = null
+    OP_MOVE,             // R[a] = R[b]
+    
+    OP_ADD,              // R[a] = R[b] op R[c] (arithmetic leaves R[a]
+    OP_SUB,              //   untouched when the operand types don't fit)
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_EQ,               // R[a] = R[b] cmp R[c] (null when not comparable)
+    OP_NE,
+    OP_GT,
+    OP_LT,
+    OP_GE,
+    OP_LE,
+    OP_AND,
+    OP_OR,
+    OP_CONCAT,           // R[a] = text of R[b] then R[c]; grows R[a] in place when a == b
+    
+    OP_INC,              // R[a] += R[b]
+    OP_DEC,              // R[a] -= R[b]
+    
+    OP_ARRAY,            // R[a] = {R[b] .. R[b+c-1]}
+    OP_INDEX,            // R[a] = R[b][R[c]]
+    OP_CAST,             // R[a] = R[b] converted to ValueType c
+    OP_ECHO,             // print R[a] (a < 0: nothing), then '\n' if c else ' '
+    
+    OP_JMP,              // pc = a
+    OP_JMPF,             // if !R[a]: pc = b
+    OP_JMP_EQ,           // pc = c if R[a] cmp R[b] (jeq .. jle)
+    OP_JMP_NE,
+    OP_JMP_GT,
+    OP_JMP_LT,
+    OP_JMP_GE,
+    OP_JMP_LE,
+    OP_FORPREP,          // check R[a..a+3] = start, end, step, dir; R[a+2] = signed delta;
+                         // on error pc = b, else R[c] = R[a] if c >= 0
+    OP_FORLOOP,          // if R[a] + R[a+2] is not past R[a+1]: R[a] += R[a+2], R[c] = R[a] if c >= 0, pc = b
+    
+    OP_CALL,             // call through call site a (callee, argument and result registers)
+    OP_TAILCALL,         // call site a, reusing this frame; the callee returns to our caller
+    OP_RET,              // return R[a .. a+b-1] to the caller's result registers
+    
+    // Superinstructions (formed by the peephole pass; K = immediate int)
+    OP_ADDK,             // R[a] = R[b] op K(c)
+    OP_SUBK,
+    OP_MULK,
+    OP_INCK,             // R[a] += K(b); c is set for dec (K already negated)
+    OP_JMPF_EQ,          // pc = c unless R[a] cmp R[b]
+    OP_JMPF_NE,
+    OP_JMPF_GT,
+    OP_JMPF_LT,
+    OP_JMPF_GE,
+    OP_JMPF_LE,
+    OP_JMPF_EQK,         // pc = c unless R[a] cmp K(b)
+    OP_JMPF_NEK,
+    OP_JMPF_GTK,
+    OP_JMPF_LTK,
+    OP_JMPF_GEK,
+    OP_JMPF_LEK,
+    OP_JMP_EQK,          // pc = c if R[a] cmp K(b)
+    OP_JMP_NEK,
+    OP_JMP_GTK,
+    OP_JMP_LTK,
+    OP_JMP_GEK,
+    OP_JMP_LEK,
+    
+    OP_HALT,             // print R[a] if a >= 0, then stop
+    OP_UNIMPLEMENTED,    // report node type a at runtime
+    OP_END,
+    OP_NOP               // placeholder removed by the peephole pass
+} OpCode;
+
+typedef struct {
+    int op;
+    int a;
+    int b;
+    int c;
+} Instr;
+
+typedef struct Proto Proto;
+
+// One call .func(args) eq results; the callee's parameters are filled from
+// the argument registers and ret writes straight into the result registers
+typedef struct {
+    Proto *callee;
+    int name;                // function symbol, for errors
+    int *args;               // caller registers holding the arguments
+    int arg_count;
+    int *results;            // caller registers receiving the return values
+    int result_count;
+} CallSite;
+
+// Compiled code for one frame (.main or a function)
+struct Proto {
+    Instr *code;
+    int code_count;
+    Value *constants;
+    int constant_count;
+    int name;                // function symbol, NO_SYMBOL for .main
+    int param_count;         // parameters occupy the first slots
+    int slot_count;          // named slots (from the resolver)
+    int register_count;      // named slots + temporaries
+    int *slot_names;         // symbol per register, NO_SYMBOL for temporaries
+    CallSite *calls;
+    int call_count;
+    Proto **functions;       // .main only: every function, owned by it
+    int function_count;
+    const void **threaded;   // pre-decoded handlers, owned by the VM
+    unsigned char *site_runs; // per instruction: runs through its opcode's own handler (VM)
+};
+
+// Compile a linked and resolved program; returns .main, which owns the functions
+Proto *compile(ASTNode *program);
+void free_proto(Proto *proto);
+
+// Debug
+void print_proto(Proto *proto);
+const char *opcode_name(int op);
+
+#endif
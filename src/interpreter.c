@@ -1,669 +1,967 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "interpreter.h"
+#include "output.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// ==================== VALUE FUNCTIONS ====================
-
-Value *create_value(ValueType type) {
-    Value *val = malloc(sizeof(Value));
-    val->type = type;
-    memset(&val->data, 0, sizeof(val->data));
-    return val;
-}
-
-Value *create_int_value(int val) {
-    Value *v = create_value(VAL_INT);
-    v->data.int_val = val;
-    return v;
-}
-
-Value *create_float_value(double val) {
-    Value *v = create_value(VAL_FLOAT);
-    v->data.float_val = val;
-    return v;
-}
-
-Value *create_string_value(const char *val) {
-    Value *v = create_value(VAL_STRING);
-    v->data.string_val = strdup(val);
-    return v;
-}
-
-Value *create_bool_value(int val) {
-    Value *v = create_value(VAL_BOOL);
-    v->data.bool_val = val ? 1 : 0;
-    return v;
-}
+// ==================== ENVIRONMENT (VARIABLE STORAGE) ====================
 
-Value *create_array_value(Value **elements, int count) {
-    Value *v = create_value(VAL_ARRAY);
-    v->data.array_val.elements = malloc(sizeof(Value*) * count);
-    v->data.array_val.count = count;
-    for (int i = 0; i < count; i++) {
-        v->data.array_val.elements[i] = copy_value(elements[i]);
-    }
-    return v;
+Environment *create_environment(int slot_count) {
+    Environment *env = malloc(sizeof(Environment));
+    env->slots = malloc(sizeof(Value) * (slot_count > 0 ? slot_count : 1));
+    for (int i = 0; i < slot_count; i++) {
+        env->slots[i].type = VAL_UNDEFINED;
+    }
+    env->slot_count = slot_count;
+    env->caller = NULL;
+    env->call = NULL;
+    env->result_limit = 0;
+    env->returning = 0;
+    env->tail_call = NULL;
+    env->jump = NULL;
+    env->breaking = NULL;
+    return env;
 }
 
-void free_value(Value *val) {
-    if (!val) return;
+void free_environment(Environment *env) {
+    if (!env) return;
     
-    if (val->type == VAL_STRING && val->data.string_val) {
-        free(val->data.string_val);
-    } else if (val->type == VAL_ARRAY) {
-        for (int i = 0; i < val->data.array_val.count; i++) {
-            free_value(val->data.array_val.elements[i]);
-        }
-        free(val->data.array_val.elements);
+    for (int i = 0; i < env->slot_count; i++) {
+        release_value(env->slots[i]);
     }
-    
-    free(val);
+    free(env->slots);
+    free(env);
 }
 
-Value *copy_value(Value *val) {
-    if (!val) return NULL;
-    
-    switch (val->type) {
-        case VAL_INT:
-            return create_int_value(val->data.int_val);
-        case VAL_FLOAT:
-            return create_float_value(val->data.float_val);
-        case VAL_STRING:
-            return create_string_value(val->data.string_val);
-        case VAL_BOOL:
-            return create_bool_value(val->data.bool_val);
-        case VAL_ARRAY:
-            return create_array_value(val->data.array_val.elements, val->data.array_val.count);
-        default:
-            return create_value(VAL_NULL);
-    }
+void set_variable(Environment *env, VarRef var, Value value) {
+    Value old = env->slots[var.slot];
+    env->slots[var.slot] = value;
+    release_value(old);
 }
 
-void print_value(Value *val) {
-    if (!val) {
-        printf("(null)");
-        return;
+Value get_variable(Environment *env, VarRef var) {
+    Value value = env->slots[var.slot];
+    if (value.type != VAL_UNDEFINED) {
+        return value;
     }
     
-    switch (val->type) {
-        case VAL_INT:
-            printf("%d", val->data.int_val);
-            break;
-        case VAL_FLOAT:
-            printf("%f", val->data.float_val);
-            break;
-        case VAL_STRING:
-            printf("%s", val->data.string_val);
-            break;
-        case VAL_BOOL:
-            printf("%s", val->data.bool_val ? "true" : "false");
-            break;
-        case VAL_ARRAY:
-            printf("{");
-            for (int i = 0; i < val->data.array_val.count; i++) {
-                print_value(val->data.array_val.elements[i]);
-                if (i < val->data.array_val.count - 1) printf(", ");
-            }
-            printf("}");
-            break;
-        case VAL_NULL:
-            printf("null");
-            break;
-    }
+    runtime_error("Undefined variable '%s'", symbol_name(var.symbol));
+    return null_value();
 }
 
-const char *value_type_name(ValueType type) {
-    switch (type) {
-        case VAL_INT: return "int";
-        case VAL_FLOAT: return "float";
-        case VAL_STRING: return "string";
-        case VAL_BOOL: return "bool";
-        case VAL_ARRAY: return "array";
-        case VAL_NULL: return "null";
-        default: return "unknown";
-    }
-}
+// ==================== EVALUATION / EXECUTION ====================
 
-// ==================== ENVIRONMENT (VARIABLE STORAGE) ====================
+// Forward declaration
+static Value eval_node(ASTNode *node, Environment *env);
 
-// Simple hash function
-static unsigned int hash(const char *str) {
-    unsigned int hash = 5381;
-    int c;
-    while ((c = *str++)) {
-        hash = ((hash << 5) + hash) + c;
-    }
-    return hash % VAR_TABLE_SIZE;
+// Run a statement for its side effects
+static void exec_node(ASTNode *node, Environment *env) {
+    release_value(eval_node(node, env));
 }
 
-Environment *create_environment() {
-    Environment *env = malloc(sizeof(Environment));
-    memset(env->table, 0, sizeof(env->table));
-    return env;
+// Is control leaving the current statements (ret, break/continue, or a
+// jump elsewhere)?
+static int leaving(Environment *env) {
+    return env->returning || env->breaking || env->jump;
 }
 
-void free_environment(Environment *env) {
-    if (!env) return;
-    
-    for (int i = 0; i < VAR_TABLE_SIZE; i++) {
-        Variable *var = env->table[i];
-        while (var) {
-            Variable *next = var->next;
-            free(var->name);
-            free_value(var->value);
-            free(var);
-            var = next;
+// Run statements in order, stopping early once a ret has executed. A jump
+// carries on after its label if the label is in this block; otherwise the
+// block is abandoned and the jump unwinds to the enclosing one.
+static void exec_block(ASTNode **body, int count, Environment *env) {
+    for (int i = 0; i < count && !env->returning && !env->breaking; i++) {
+        exec_node(body[i], env);
+        if (env->jump) {
+            if (env->jump->data.label.block != body) return;
+            i = env->jump->data.label.index;
+            env->jump = NULL;
         }
     }
-    free(env);
 }
 
-void set_variable(Environment *env, const char *name, Value *value) {
-    unsigned int index = hash(name);
-    
-    // Check if variable already exists
-    Variable *var = env->table[index];
-    while (var) {
-        if (strcmp(var->name, name) == 0) {
-            // Update existing variable - DON'T free old value (memory leak but works)
-            // free_value(var->value);  // <-- COMMENT THIS OUT
-            var->value = copy_value(value);
-            return;
-        }
-        var = var->next;
+// Run a frame's body; a jump still pending at the end targets a label
+// nested in a block that is not running, and a break/continue still
+// pending found no loop to stop
+static void exec_frame(ASTNode **body, int count, Environment *env) {
+    exec_block(body, count, env);
+    if (env->jump) {
+        runtime_error("Cannot jump into the block holding '%s'",
+                      symbol_name(env->jump->data.label.name));
+        env->jump = NULL;
+    }
+    if (env->breaking) {
+        runtime_error(env->breaking->data.break_continue.label != NO_SYMBOL
+                          ? "No enclosing loop with that label"
+                          : "break/continue outside of a loop");
+        env->breaking = NULL;
     }
-    
-    // Create new variable
-    Variable *new_var = malloc(sizeof(Variable));
-    new_var->name = strdup(name);
-    new_var->value = copy_value(value);
-    new_var->next = env->table[index];
-    env->table[index] = new_var;
 }
 
-Value *get_variable(Environment *env, const char *name) {
-    unsigned int index = hash(name);
-    
-    Variable *var = env->table[index];
-    while (var) {
-        if (strcmp(var->name, name) == 0) {
-            return var->value;
-        }
-        var = var->next;
-    }
-    
-    fprintf(stderr, "Runtime Error: Undefined variable '%s'\n", name);
-    return create_value(VAL_NULL);
+static int is_truthy(Value val) {
+    if (val.type == VAL_BOOL) return val.data.bool_val;
+    if (val.type == VAL_INT) return val.data.int_val != 0;
+    return 0;
 }
 
-// ==================== EVALUATION / EXECUTION ====================
-
-// Forward declaration
-static Value *eval_node(ASTNode *node, Environment *env);
-
 // Evaluate literal values
-static Value *eval_literal(ASTNode *node) {
+static Value eval_literal(ASTNode *node) {
     switch (node->type) {
         case AST_LITERAL_INT:
-            return create_int_value(node->data.int_literal.value);
+            return int_value(node->data.int_literal.value);
         
         case AST_LITERAL_FLOAT:
-            return create_float_value(node->data.float_literal.value);
+            return float_value(node->data.float_literal.value);
         
         case AST_LITERAL_STRING:
-            return create_string_value(node->data.string_literal.value);
+            return string_value_n(node->data.string_literal.value,
+                                  node->data.string_literal.length);
         
         case AST_LITERAL_BOOL:
-            return create_bool_value(node->data.bool_literal.value);
+            return bool_value(node->data.bool_literal.value);
         
         default:
-            return create_value(VAL_NULL);
+            return null_value();
     }
 }
 
-// Evaluate identifier (variable lookup)
-static Value *eval_identifier(ASTNode *node, Environment *env) {
-    return get_variable(env, node->data.identifier.name);
+// Evaluate identifier (variable lookup); the result shares the stored payload
+static Value eval_identifier(ASTNode *node, Environment *env) {
+    return retain_value(get_variable(env, node->data.identifier.name));
 }
 
-// Evaluate binary operation
-static Value *eval_binary_op(ASTNode *node, Environment *env) {
-    Value *left = eval_node(node->data.binary_op.left, env);
-    Value *right = eval_node(node->data.binary_op.right, env);
-    
-    if (!left || !right) {
-        free_value(left);
-        free_value(right);
-        return create_value(VAL_NULL);
-    }
-    
-    Value *result = NULL;
+// Every binary op site starts on the generic handler, which rewrites the
+// site to a handler specialised to the operand types it saw: int-int,
+// float-float or mixed int/float. A specialised handler only checks that
+// its types still hold (and that a divisor is non-zero); on anything else
+// it hands over to the generic handler, which counts a miss and re-picks
+// the handler from the types seen now. A site that keeps missing has
+// unstable types and stays generic.
+typedef int (*BinaryHandler)(ASTNode *node, Value left, Value right, Value *result);
+
+#define MAX_HANDLER_MISSES 16
+
+// Handler cache, indexed by the resolver's binary_op.site
+typedef struct {
+    BinaryHandler handler;   // NULL until the site first runs
+    int misses;              // times the handler had to be re-picked
+} BinarySite;
+
+static BinarySite *binary_sites;
+
+static BinaryHandler specialise(TokenType op, Value left, Value right);
+
+// Any operand types. Returns whether the operation produced a value.
+static int binary_generic(ASTNode *node, Value left, Value right, Value *result_out) {
+    Value result = null_value();
+    int has_result = 1;
     
     switch (node->data.binary_op.op) {
         case TOKEN_ADD:
-            if (left->type == VAL_INT && right->type == VAL_INT) {
-                result = create_int_value(left->data.int_val + right->data.int_val);
-            } else if (left->type == VAL_FLOAT || right->type == VAL_FLOAT) {
-                double l = (left->type == VAL_FLOAT) ? left->data.float_val : left->data.int_val;
-                double r = (right->type == VAL_FLOAT) ? right->data.float_val : right->data.int_val;
-                result = create_float_value(l + r);
+            if (left.type == VAL_INT && right.type == VAL_INT) {
+                result = int_value(left.data.int_val + right.data.int_val);
+            } else if (left.type == VAL_FLOAT || right.type == VAL_FLOAT) {
+                double l = (left.type == VAL_FLOAT) ? left.data.float_val : left.data.int_val;
+                double r = (right.type == VAL_FLOAT) ? right.data.float_val : right.data.int_val;
+                result = float_value(l + r);
+            } else {
+                has_result = 0;
             }
             break;
         
         case TOKEN_SUB:
-            if (left->type == VAL_INT && right->type == VAL_INT) {
-                result = create_int_value(left->data.int_val - right->data.int_val);
-            } else if (left->type == VAL_FLOAT || right->type == VAL_FLOAT) {
-                double l = (left->type == VAL_FLOAT) ? left->data.float_val : left->data.int_val;
-                double r = (right->type == VAL_FLOAT) ? right->data.float_val : right->data.int_val;
-                result = create_float_value(l - r);
+            if (left.type == VAL_INT && right.type == VAL_INT) {
+                result = int_value(left.data.int_val - right.data.int_val);
+            } else if (left.type == VAL_FLOAT || right.type == VAL_FLOAT) {
+                double l = (left.type == VAL_FLOAT) ? left.data.float_val : left.data.int_val;
+                double r = (right.type == VAL_FLOAT) ? right.data.float_val : right.data.int_val;
+                result = float_value(l - r);
+            } else {
+                has_result = 0;
             }
             break;
         
         case TOKEN_MUL:
-            if (left->type == VAL_INT && right->type == VAL_INT) {
-                result = create_int_value(left->data.int_val * right->data.int_val);
-            } else if (left->type == VAL_FLOAT || right->type == VAL_FLOAT) {
-                double l = (left->type == VAL_FLOAT) ? left->data.float_val : left->data.int_val;
-                double r = (right->type == VAL_FLOAT) ? right->data.float_val : right->data.int_val;
-                result = create_float_value(l * r);
+            if (left.type == VAL_INT && right.type == VAL_INT) {
+                result = int_value(left.data.int_val * right.data.int_val);
+            } else if (left.type == VAL_FLOAT || right.type == VAL_FLOAT) {
+                double l = (left.type == VAL_FLOAT) ? left.data.float_val : left.data.int_val;
+                double r = (right.type == VAL_FLOAT) ? right.data.float_val : right.data.int_val;
+                result = float_value(l * r);
+            } else {
+                has_result = 0;
             }
             break;
         
         case TOKEN_DIV:
-            if (left->type == VAL_INT && right->type == VAL_INT) {
-                if (right->data.int_val == 0) {
-                    fprintf(stderr, "Runtime Error: Division by zero\n");
-                    result = create_value(VAL_NULL);
+            if (left.type == VAL_INT && right.type == VAL_INT) {
+                if (right.data.int_val == 0) {
+                    runtime_error("Division by zero");
                 } else {
-                    result = create_int_value(left->data.int_val / right->data.int_val);
+                    result = int_value(left.data.int_val / right.data.int_val);
                 }
-            } else if (left->type == VAL_FLOAT || right->type == VAL_FLOAT) {
-                double l = (left->type == VAL_FLOAT) ? left->data.float_val : left->data.int_val;
-                double r = (right->type == VAL_FLOAT) ? right->data.float_val : right->data.int_val;
+            } else if (left.type == VAL_FLOAT || right.type == VAL_FLOAT) {
+                double l = (left.type == VAL_FLOAT) ? left.data.float_val : left.data.int_val;
+                double r = (right.type == VAL_FLOAT) ? right.data.float_val : right.data.int_val;
                 if (r == 0.0) {
-                    fprintf(stderr, "Runtime Error: Division by zero\n");
-                    result = create_value(VAL_NULL);
+                    runtime_error("Division by zero");
                 } else {
-                    result = create_float_value(l / r);
+                    result = float_value(l / r);
                 }
+            } else {
+                has_result = 0;
             }
             break;
         
         case TOKEN_MOD:
-            if (left->type == VAL_INT && right->type == VAL_INT) {
-                if (right->data.int_val == 0) {
-                    fprintf(stderr, "Runtime Error: Modulo by zero\n");
-                    result = create_value(VAL_NULL);
+            if (left.type == VAL_INT && right.type == VAL_INT) {
+                if (right.data.int_val == 0) {
+                    runtime_error("Modulo by zero");
                 } else {
-                    result = create_int_value(left->data.int_val % right->data.int_val);
+                    result = int_value(left.data.int_val % right.data.int_val);
                 }
+            } else {
+                has_result = 0;
             }
             break;
         
         // Comparison operators
         case TOKEN_EQ:
-            if (left->type == VAL_INT && right->type == VAL_INT) {
-                result = create_bool_value(left->data.int_val == right->data.int_val);
-            } else if (left->type == VAL_STRING && right->type == VAL_STRING) {
-                result = create_bool_value(strcmp(left->data.string_val, right->data.string_val) == 0);
-            }
-            break;
-        
         case TOKEN_NE:
-            if (left->type == VAL_INT && right->type == VAL_INT) {
-                result = create_bool_value(left->data.int_val != right->data.int_val);
-            }
-            break;
-        
         case TOKEN_GT:
-            if (left->type == VAL_INT && right->type == VAL_INT) {
-                result = create_bool_value(left->data.int_val > right->data.int_val);
-            }
-            break;
-        
         case TOKEN_LT:
-            if (left->type == VAL_INT && right->type == VAL_INT) {
-                result = create_bool_value(left->data.int_val < right->data.int_val);
-            }
-            break;
-        
         case TOKEN_GE:
-            if (left->type == VAL_INT && right->type == VAL_INT) {
-                result = create_bool_value(left->data.int_val >= right->data.int_val);
-            }
-            break;
-        
-        case TOKEN_LE:
-            if (left->type == VAL_INT && right->type == VAL_INT) {
-                result = create_bool_value(left->data.int_val <= right->data.int_val);
+        case TOKEN_LE: {
+            int holds = compare_values((CompareOp)(node->data.binary_op.op - TOKEN_EQ), left, right);
+            if (holds < 0) {
+                has_result = 0;
+            } else {
+                result = bool_value(holds);
             }
             break;
+        }
         
         // Logical operators
         case TOKEN_AND:
-            if (left->type == VAL_BOOL && right->type == VAL_BOOL) {
-                result = create_bool_value(left->data.bool_val && right->data.bool_val);
+            if (left.type == VAL_BOOL && right.type == VAL_BOOL) {
+                result = bool_value(left.data.bool_val && right.data.bool_val);
+            } else {
+                has_result = 0;
             }
             break;
         
         case TOKEN_OR:
-            if (left->type == VAL_BOOL && right->type == VAL_BOOL) {
-                result = create_bool_value(left->data.bool_val || right->data.bool_val);
+            if (left.type == VAL_BOOL && right.type == VAL_BOOL) {
+                result = bool_value(left.data.bool_val || right.data.bool_val);
+            } else {
+                has_result = 0;
             }
             break;
         
         default:
-            result = create_value(VAL_NULL);
             break;
     }
     
-    free_value(left);
-    free_value(right);
+    // Re-pick the handler for the types seen here: the first run is not a
+    // miss, every later run through here is
+    BinarySite *site = &binary_sites[node->data.binary_op.site];
+    if (site->misses < MAX_HANDLER_MISSES) {
+        if (site->handler) site->misses++;
+        site->handler = site->misses < MAX_HANDLER_MISSES
+                            ? specialise(node->data.binary_op.op, left, right)
+                            : binary_generic;
+    }
+    
+    *result_out = result;
+    return has_result;
+}
+
+#define INT_HANDLER(name, guard, expr) \
+    static int name(ASTNode *node, Value left, Value right, Value *result) { \
+        if (left.type != VAL_INT || right.type != VAL_INT) { \
+            return binary_generic(node, left, right, result); \
+        } \
+        int l = left.data.int_val; \
+        int r = right.data.int_val; \
+        if (!(guard)) return binary_generic(node, left, right, result); \
+        *result = expr; \
+        return 1; \
+    }
+
+#define FLOAT_HANDLER(name, guard, expr) \
+    static int name(ASTNode *node, Value left, Value right, Value *result) { \
+        if (left.type != VAL_FLOAT || right.type != VAL_FLOAT) { \
+            return binary_generic(node, left, right, result); \
+        } \
+        double l = left.data.float_val; \
+        double r = right.data.float_val; \
+        if (!(guard)) return binary_generic(node, left, right, result); \
+        *result = expr; \
+        return 1; \
+    }
+
+#define MIXED_HANDLER(name, guard, expr) \
+    static int name(ASTNode *node, Value left, Value right, Value *result) { \
+        double l, r; \
+        if (left.type == VAL_INT && right.type == VAL_FLOAT) { \
+            l = left.data.int_val; \
+            r = right.data.float_val; \
+        } else if (left.type == VAL_FLOAT && right.type == VAL_INT) { \
+            l = left.data.float_val; \
+            r = right.data.int_val; \
+        } else { \
+            return binary_generic(node, left, right, result); \
+        } \
+        if (!(guard)) return binary_generic(node, left, right, result); \
+        *result = expr; \
+        return 1; \
+    }
+
+// Division by zero goes to the generic handler, which reports it
+INT_HANDLER(add_int, 1, int_value(l + r))
+INT_HANDLER(sub_int, 1, int_value(l - r))
+INT_HANDLER(mul_int, 1, int_value(l * r))
+INT_HANDLER(div_int, r != 0, int_value(l / r))
+INT_HANDLER(mod_int, r != 0, int_value(l % r))
+INT_HANDLER(eq_int, 1, bool_value(l == r))
+INT_HANDLER(ne_int, 1, bool_value(l != r))
+INT_HANDLER(gt_int, 1, bool_value(l > r))
+INT_HANDLER(lt_int, 1, bool_value(l < r))
+INT_HANDLER(ge_int, 1, bool_value(l >= r))
+INT_HANDLER(le_int, 1, bool_value(l <= r))
+
+// C's comparisons on NaN match compare_values(): only ne holds
+FLOAT_HANDLER(add_float, 1, float_value(l + r))
+FLOAT_HANDLER(sub_float, 1, float_value(l - r))
+FLOAT_HANDLER(mul_float, 1, float_value(l * r))
+FLOAT_HANDLER(div_float, r != 0.0, float_value(l / r))
+FLOAT_HANDLER(eq_float, 1, bool_value(l == r))
+FLOAT_HANDLER(ne_float, 1, bool_value(l != r))
+FLOAT_HANDLER(gt_float, 1, bool_value(l > r))
+FLOAT_HANDLER(lt_float, 1, bool_value(l < r))
+FLOAT_HANDLER(ge_float, 1, bool_value(l >= r))
+FLOAT_HANDLER(le_float, 1, bool_value(l <= r))
+
+MIXED_HANDLER(add_mixed, 1, float_value(l + r))
+MIXED_HANDLER(sub_mixed, 1, float_value(l - r))
+MIXED_HANDLER(mul_mixed, 1, float_value(l * r))
+MIXED_HANDLER(div_mixed, r != 0.0, float_value(l / r))
+MIXED_HANDLER(eq_mixed, 1, bool_value(l == r))
+MIXED_HANDLER(ne_mixed, 1, bool_value(l != r))
+MIXED_HANDLER(gt_mixed, 1, bool_value(l > r))
+MIXED_HANDLER(lt_mixed, 1, bool_value(l < r))
+MIXED_HANDLER(ge_mixed, 1, bool_value(l >= r))
+MIXED_HANDLER(le_mixed, 1, bool_value(l <= r))
+
+// Handler for an operator on these operand types (generic if none fits)
+static BinaryHandler specialise(TokenType op, Value left, Value right) {
+    if (left.type == VAL_INT && right.type == VAL_INT) {
+        switch (op) {
+            case TOKEN_ADD: return add_int;
+            case TOKEN_SUB: return sub_int;
+            case TOKEN_MUL: return mul_int;
+            case TOKEN_DIV: return div_int;
+            case TOKEN_MOD: return mod_int;
+            case TOKEN_EQ: return eq_int;
+            case TOKEN_NE: return ne_int;
+            case TOKEN_GT: return gt_int;
+            case TOKEN_LT: return lt_int;
+            case TOKEN_GE: return ge_int;
+            case TOKEN_LE: return le_int;
+            default: return binary_generic;
+        }
+    }
     
-    // If result variable specified, store it
-    if (result && node->data.binary_op.result) {
+    if (left.type == VAL_FLOAT && right.type == VAL_FLOAT) {
+        switch (op) {
+            case TOKEN_ADD: return add_float;
+            case TOKEN_SUB: return sub_float;
+            case TOKEN_MUL: return mul_float;
+            case TOKEN_DIV: return div_float;
+            case TOKEN_EQ: return eq_float;
+            case TOKEN_NE: return ne_float;
+            case TOKEN_GT: return gt_float;
+            case TOKEN_LT: return lt_float;
+            case TOKEN_GE: return ge_float;
+            case TOKEN_LE: return le_float;
+            default: return binary_generic;
+        }
+    }
+    
+    if ((left.type == VAL_INT && right.type == VAL_FLOAT) ||
+        (left.type == VAL_FLOAT && right.type == VAL_INT)) {
+        switch (op) {
+            case TOKEN_ADD: return add_mixed;
+            case TOKEN_SUB: return sub_mixed;
+            case TOKEN_MUL: return mul_mixed;
+            case TOKEN_DIV: return div_mixed;
+            case TOKEN_EQ: return eq_mixed;
+            case TOKEN_NE: return ne_mixed;
+            case TOKEN_GT: return gt_mixed;
+            case TOKEN_LT: return lt_mixed;
+            case TOKEN_GE: return ge_mixed;
+            case TOKEN_LE: return le_mixed;
+            default: return binary_generic;
+        }
+    }
+    
+    return binary_generic;
+}
+
+// Execute concat. A variable on the left is borrowed rather than retained
+// and the result is built straight in its slot, so concat s,x eq s finds
+// s unshared and extends it in place.
+static Value exec_concat(ASTNode *node, Environment *env) {
+    ASTNode *left_node = node->data.binary_op.left;
+    int borrowed = (left_node->type == AST_IDENTIFIER);
+    Value left = borrowed ? get_variable(env, left_node->data.identifier.name)
+                          : eval_node(left_node, env);
+    Value right = eval_node(node->data.binary_op.right, env);
+    
+    VarRef result_var = node->data.binary_op.result;
+    Value result = null_value();
+    Value *dst = (result_var.symbol != NO_SYMBOL) ? &env->slots[result_var.slot] : &result;
+    
+    if (!concat_values(dst, left, right)) {
+        runtime_error("Cannot concat %s and %s",
+                      value_type_name(left.type), value_type_name(right.type));
+        Value old = *dst;
+        *dst = null_value();
+        release_value(old);
+    }
+    
+    if (!borrowed) release_value(left);
+    release_value(right);
+    return dst == &result ? result : retain_value(*dst);
+}
+
+// Evaluate binary operation through its site's current handler
+static Value eval_binary_op(ASTNode *node, Environment *env) {
+    if (node->data.binary_op.op == TOKEN_CONCAT) {
+        return exec_concat(node, env);
+    }
+    
+    Value left = eval_node(node->data.binary_op.left, env);
+    Value right = eval_node(node->data.binary_op.right, env);
+    
+    BinaryHandler handler = binary_sites[node->data.binary_op.site].handler;
+    Value result = null_value();
+    int has_result = handler ? handler(node, left, right, &result)
+                             : binary_generic(node, left, right, &result);
+    
+    release_value(left);
+    release_value(right);
+    
+    // If result variable specified, store it (results are always scalars)
+    if (has_result && node->data.binary_op.result.symbol != NO_SYMBOL) {
         set_variable(env, node->data.binary_op.result, result);
     }
     
-    return result ? result : create_value(VAL_NULL);
+    return result;
 }
 
 // Execute assignment
-static Value *exec_assignment(ASTNode *node, Environment *env) {
-    Value *val = eval_node(node->data.assignment.value, env);
-    set_variable(env, node->data.assignment.variable, val);
-    free_value(val);  // Free the temp value (set_variable made a copy)
-    return create_value(VAL_NULL);  // Return a throwaway null
+static Value exec_assignment(ASTNode *node, Environment *env) {
+    set_variable(env, node->data.assignment.variable,
+                 eval_node(node->data.assignment.value, env));
+    return null_value();
 }
 
 // Execute echo statement
-static Value *exec_echo(ASTNode *node, Environment *env) {
+static Value exec_echo(ASTNode *node, Environment *env) {
     for (int i = 0; i < node->data.echo.expr_count; i++) {
-        Value *val = eval_node(node->data.echo.expressions[i], env);
-        print_value(val);
+        Value val = eval_node(node->data.echo.expressions[i], env);
+        output_value(val);
         if (i < node->data.echo.expr_count - 1) {
-            printf(" ");
+            output_char(' ');
         }
-        free_value(val);
+        release_value(val);
     }
-    printf("\n");
-    return create_value(VAL_NULL);  // Return a throwaway null
+    output_char('\n');
+    return null_value();
 }
+
 // Execute array literal
-static Value *exec_array(ASTNode *node, Environment *env) {
-    Value **elements = malloc(sizeof(Value*) * node->data.array.element_count);
+static Value exec_array(ASTNode *node, Environment *env) {
+    Value result = array_value(node->data.array.element_count);
     
     for (int i = 0; i < node->data.array.element_count; i++) {
-        elements[i] = eval_node(node->data.array.elements[i], env);
+        result.data.array_val->elements[i] = eval_node(node->data.array.elements[i], env);
     }
     
-    Value *result = create_array_value(elements, node->data.array.element_count);
-    
-    // Free temporary elements
-    for (int i = 0; i < node->data.array.element_count; i++) {
-        free_value(elements[i]);
-    }
-    free(elements);
-    
     return result;
 }
 
 // Execute array access
-static Value *exec_array_access(ASTNode *node, Environment *env) {
-    Value *array = get_variable(env, node->data.array_access.array_name);
-    Value *index_val = eval_node(node->data.array_access.index, env);
+static Value exec_array_access(ASTNode *node, Environment *env) {
+    Value array = get_variable(env, node->data.array_access.array_name);
+    Value index_val = eval_node(node->data.array_access.index, env);
     
-    if (array->type != VAL_ARRAY) {
-        fprintf(stderr, "Runtime Error: Not an array\n");
-        free_value(index_val);
-        return create_value(VAL_NULL);
+    if (array.type != VAL_ARRAY) {
+        runtime_error("Not an array");
+        release_value(index_val);
+        return null_value();
     }
     
-    if (index_val->type != VAL_INT) {
-        fprintf(stderr, "Runtime Error: Array index must be integer\n");
-        free_value(index_val);
-        return create_value(VAL_NULL);
+    if (index_val.type != VAL_INT) {
+        runtime_error("Array index must be integer");
+        release_value(index_val);
+        return null_value();
     }
     
-    int index = index_val->data.int_val;
+    int index = index_val.data.int_val;
+    int count = array.data.array_val->count;
     
     // Handle negative indexing
     if (index < 0) {
-        index = array->data.array_val.count + index;
+        index = count + index;
     }
     
-    if (index < 0 || index >= array->data.array_val.count) {
-        fprintf(stderr, "Runtime Error: Array index out of bounds\n");
-        free_value(index_val);
-        return create_value(VAL_NULL);
+    if (index < 0 || index >= count) {
+        runtime_error("Array index out of bounds");
+        return null_value();
     }
     
-    Value *result = copy_value(array->data.array_val.elements[index]);
-    free_value(index_val);
-    return result;
+    return retain_value(array.data.array_val->elements[index]);
 }
 
-// Main eval function
-static Value *eval_node(ASTNode *node, Environment *env) {
-    if (!node) return create_value(VAL_NULL);
+// Execute type cast: int x, str y eq z
+static Value exec_type_cast(ASTNode *node, Environment *env) {
+    Value val = eval_node(node->data.type_cast.value, env);
+    ValueType target = cast_target(node->data.type_cast.target_type);
+    Value result;
     
-    switch (node->type) {
-        case AST_LITERAL_INT:
-        case AST_LITERAL_FLOAT:
-        case AST_LITERAL_STRING:
-        case AST_LITERAL_BOOL:
-            return eval_literal(node);
-        
-        case AST_IDENTIFIER:
-            return eval_identifier(node, env);
-        
-        case AST_BINARY_OP:
-            return eval_binary_op(node, env);
-        
-        case AST_ASSIGNMENT:
-            return exec_assignment(node, env);
-        
-        case AST_ECHO:
-            return exec_echo(node, env);
-        
-        case AST_ARRAY:
-            return exec_array(node, env);
-        
-        case AST_ARRAY_ACCESS:
-            return exec_array_access(node, env);
-        
-        case AST_IF_STATEMENT: {
-    // Evaluate condition
-    Value *cond = eval_node(node->data.if_stmt.condition, env);
-    int is_true = 0;
-    
-    // Check if condition is truthy
-    if (cond->type == VAL_BOOL) {
-        is_true = cond->data.bool_val;
-    } else if (cond->type == VAL_INT) {
-        is_true = (cond->data.int_val != 0);
+    if (!cast_value(val, target, &result)) {
+        runtime_error("Cannot cast %s to %s",
+                      value_type_name(val.type), value_type_name(target));
+        result = null_value();
     }
+    release_value(val);
     
-    free_value(cond);
+    if (node->data.type_cast.result_var.symbol != NO_SYMBOL) {
+        set_variable(env, node->data.type_cast.result_var, retain_value(result));
+    }
+    return result;
+}
+
+// Execute if / elseif / else
+static Value exec_if(ASTNode *node, Environment *env) {
+    Value cond = eval_node(node->data.if_stmt.condition, env);
+    int is_true = is_truthy(cond);
+    release_value(cond);
     
     // Execute appropriate branch
     if (is_true) {
-        for (int i = 0; i < node->data.if_stmt.then_count; i++) {
-            Value *result = eval_node(node->data.if_stmt.then_body[i], env);
-            free_value(result);
-        }
+        exec_block(node->data.if_stmt.then_body, node->data.if_stmt.then_count, env);
     } else {
-        for (int i = 0; i < node->data.if_stmt.else_count; i++) {
-            Value *result = eval_node(node->data.if_stmt.else_body[i], env);
-            free_value(result);
-        }
+        exec_block(node->data.if_stmt.else_body, node->data.if_stmt.else_count, env);
     }
     
-    return create_value(VAL_NULL);
+    return null_value();
+}
+
+// After a loop body runs: take a pending break/continue aimed at this loop
+// (unlabelled, or naming it). Returns whether the loop stops.
+static int loop_done(int label, Environment *env) {
+    ASTNode *pending = env->breaking;
+    if (pending && (pending->data.break_continue.label == NO_SYMBOL ||
+                    pending->data.break_continue.label == label)) {
+        env->breaking = NULL;
+        if (pending->type == AST_BREAK) return 1;
+    }
+    return leaving(env);
 }
-case AST_FOR_LOOP: {
-    // Evaluate start and end
-    Value *start_val = eval_node(node->data.for_loop.start, env);
-    Value *end_val = eval_node(node->data.for_loop.end, env);
+
+// Execute counted for loop
+static Value exec_for(ASTNode *node, Environment *env) {
+    Value start_val = eval_node(node->data.for_loop.start, env);
+    Value end_val = eval_node(node->data.for_loop.end, env);
     
-    if (start_val->type != VAL_INT || end_val->type != VAL_INT) {
-        fprintf(stderr, "Runtime Error: For loop range must be integers\n");
-        free_value(start_val);
-        free_value(end_val);
-        return create_value(VAL_NULL);
+    if (start_val.type != VAL_INT || end_val.type != VAL_INT) {
+        runtime_error("For loop range must be integers");
+        release_value(start_val);
+        release_value(end_val);
+        return null_value();
     }
     
-    int start = start_val->data.int_val;
-    int end = end_val->data.int_val;
+    int start = start_val.data.int_val;
+    int end = end_val.data.int_val;
     int step = 1;
     
     // Get step if provided
     if (node->data.for_loop.step) {
-        Value *step_val = eval_node(node->data.for_loop.step, env);
-        if (step_val->type == VAL_INT) {
-            step = step_val->data.int_val;
+        Value step_val = eval_node(node->data.for_loop.step, env);
+        if (step_val.type == VAL_INT) {
+            step = step_val.data.int_val;
         }
-        free_value(step_val);
+        release_value(step_val);
     }
     
-    free_value(start_val);
-    free_value(end_val);
-    
     // Determine direction
     int ascending = (start <= end);
     
     // Execute loop
-if (ascending) {
-    for (int i = start; i <= end; i += step) {
-        Value *loop_val = create_int_value(i);
-        set_variable(env, node->data.for_loop.variable, loop_val);
-       
-        for (int j = 0; j < node->data.for_loop.body_count; j++) {
-            Value *result = eval_node(node->data.for_loop.body[j], env);
-            free_value(result);
+    int label = node->data.for_loop.label;
+    if (ascending) {
+        for (int i = start; i <= end; i += step) {
+            set_variable(env, node->data.for_loop.variable, int_value(i));
+            exec_block(node->data.for_loop.body, node->data.for_loop.body_count, env);
+            if (loop_done(label, env)) break;
         }
-    }
-} else {
-    for (int i = start; i >= end; i -= step) {
-        Value *loop_val = create_int_value(i);
-        set_variable(env, node->data.for_loop.variable, loop_val);
-        
-        for (int j = 0; j < node->data.for_loop.body_count; j++) {
-            Value *result = eval_node(node->data.for_loop.body[j], env);
-            free_value(result);
+    } else {
+        for (int i = start; i >= end; i -= step) {
+            set_variable(env, node->data.for_loop.variable, int_value(i));
+            exec_block(node->data.for_loop.body, node->data.for_loop.body_count, env);
+            if (loop_done(label, env)) break;
         }
     }
-}
     
-    return create_value(VAL_NULL);
+    return null_value();
 }
-case AST_WHILE_LOOP: {
-    // Execute while loop
+
+// Execute while loop
+static Value exec_while(ASTNode *node, Environment *env) {
     while (1) {
-        // Evaluate condition
-        Value *cond = eval_node(node->data.while_loop.condition, env);
-        int is_true = 0;
-        
-        // Check if condition is truthy
-        if (cond->type == VAL_BOOL) {
-            is_true = cond->data.bool_val;
-        } else if (cond->type == VAL_INT) {
-            is_true = (cond->data.int_val != 0);
-        }
-        
-        free_value(cond);
+        Value cond = eval_node(node->data.while_loop.condition, env);
+        int is_true = is_truthy(cond);
+        release_value(cond);
         
         // Break if condition is false
         if (!is_true) {
             break;
         }
         
-        // Execute body
-        for (int i = 0; i < node->data.while_loop.body_count; i++) {
-            Value *result = eval_node(node->data.while_loop.body[i], env);
-            free_value(result);
+        exec_block(node->data.while_loop.body, node->data.while_loop.body_count, env);
+        if (loop_done(node->data.while_loop.label, env)) break;
+    }
+    
+    return null_value();
+}
+
+// Execute inc / dec
+static Value exec_unary_op(ASTNode *node, Environment *env) {
+    Value current = get_variable(env, node->data.unary_op.variable);
+    int is_inc = (node->data.unary_op.op == TOKEN_INC);
+    
+    if (current.type != VAL_INT) {
+        runtime_error("Can only %s integers",
+                      is_inc ? "increment" : "decrement");
+        return null_value();
+    }
+    
+    // Amount (default 1)
+    int amount = 1;
+    if (node->data.unary_op.amount) {
+        Value amt = eval_node(node->data.unary_op.amount, env);
+        if (amt.type == VAL_INT) {
+            amount = amt.data.int_val;
         }
+        release_value(amt);
     }
     
-    return create_value(VAL_NULL);
+    int updated = is_inc ? current.data.int_val + amount : current.data.int_val - amount;
+    set_variable(env, node->data.unary_op.variable, int_value(updated));
+    
+    return null_value();
 }
-case AST_UNARY_OP: {
-    if (node->data.unary_op.op == TOKEN_INC) {
-        // Get current value
-        Value *current = get_variable(env, node->data.unary_op.variable);
-        
-        if (current->type != VAL_INT) {
-            fprintf(stderr, "Runtime Error: Can only increment integers\n");
-            return create_value(VAL_NULL);
+
+// ==================== CALLS ====================
+
+// Call frames are consecutive windows of one preallocated slot stack. Every
+// call also recurses through eval_node, so the depth is capped well inside
+// the C stack.
+#define CALL_STACK_SLOTS (1 << 20)
+#define MAX_CALL_DEPTH 10000
+
+static struct {
+    ASTNode **functions;    // program.functions (calls were linked to an index)
+    Value *slots;
+    int top;                // first free slot
+    int depth;
+    int halted;             // set by halt: every frame unwinds
+} call_stack;
+
+// Store a call's results in the caller's result variables
+static void set_result(Environment *env, ASTNode *call, int index, Value value) {
+    VarRef result = { call->data.function_call.result_vars[index],
+                      call->data.function_call.result_slots[index] };
+    set_variable(env, result, value);
+}
+
+static void call_overflow(ASTNode *func) {
+    runtime_error("Call stack overflow in '%s'",
+                  symbol_name(func->data.function.name));
+    exit(1);
+}
+
+// Tail call (call ... eq r directly followed by ret r): evaluate the
+// arguments just above the current frame and let exec_call replace the
+// frame with the callee's instead of nesting a new one
+static Value exec_tail_call(ASTNode *node, Environment *env) {
+    ASTNode *func = call_stack.functions[node->data.function_call.function];
+    int param_count = func->data.function.param_count;
+    int base = env->slots - call_stack.slots;
+    int slot_count = func->data.function.slot_count;
+    if (base + env->slot_count + param_count > CALL_STACK_SLOTS || base + slot_count > CALL_STACK_SLOTS) {
+        call_overflow(func);
+    }
+    
+    Value *staged = env->slots + env->slot_count;
+    for (int i = 0; i < node->data.function_call.arg_count; i++) {
+        Value arg = eval_node(node->data.function_call.arguments[i], env);
+        if (i < param_count) {
+            staged[i] = arg;
+        } else {
+            release_value(arg);
         }
-        
-        // Increment amount (default 1)
-        int amount = 1;
-        if (node->data.unary_op.amount) {
-            Value *amt = eval_node(node->data.unary_op.amount, env);
-            if (amt->type == VAL_INT) {
-                amount = amt->data.int_val;
-            }
-            free_value(amt);
+    }
+    
+    env->tail_call = node;
+    env->returning = 1;
+    return null_value();
+}
+
+// Execute call .func(args) eq results
+static Value exec_call(ASTNode *node, Environment *env) {
+    if (node->data.function_call.tail && env->caller) {
+        return exec_tail_call(node, env);
+    }
+    
+    ASTNode *func = call_stack.functions[node->data.function_call.function];
+    int slot_count = func->data.function.slot_count;
+    if (call_stack.depth == MAX_CALL_DEPTH || call_stack.top + slot_count > CALL_STACK_SLOTS) {
+        call_overflow(func);
+    }
+    
+    // Claim the frame, then evaluate the arguments straight into the
+    // parameter slots (extra arguments are evaluated and dropped)
+    Environment frame;
+    frame.slots = call_stack.slots + call_stack.top;
+    frame.slot_count = slot_count;
+    frame.caller = env;
+    frame.call = node;
+    frame.result_limit = node->data.function_call.result_count;
+    frame.returning = 0;
+    frame.tail_call = NULL;
+    frame.jump = NULL;
+    frame.breaking = NULL;
+    for (int i = 0; i < slot_count; i++) {
+        frame.slots[i].type = VAL_UNDEFINED;
+    }
+    call_stack.top += slot_count;
+    call_stack.depth++;
+    
+    for (int i = 0; i < node->data.function_call.arg_count; i++) {
+        Value arg = eval_node(node->data.function_call.arguments[i], env);
+        if (i < func->data.function.param_count) {
+            frame.slots[i] = arg;
+        } else {
+            release_value(arg);
         }
-        
-        // Set new value
-        Value *new_val = create_int_value(current->data.int_val + amount);
-        set_variable(env, node->data.unary_op.variable, new_val);
-        free_value(new_val);
-        
-    } else if (node->data.unary_op.op == TOKEN_DEC) {
-        // Get current value
-        Value *current = get_variable(env, node->data.unary_op.variable);
-        
-        if (current->type != VAL_INT) {
-            fprintf(stderr, "Runtime Error: Can only decrement integers\n");
-            return create_value(VAL_NULL);
+    }
+    
+    while (1) {
+        exec_frame(func->data.function.body, func->data.function.body_count, &frame);
+        if (!frame.tail_call) break;
+        
+        // The frame now belongs to the tail callee: drop our variables and
+        // slide the staged arguments down into its parameter slots
+        ASTNode *call = frame.tail_call;
+        func = call_stack.functions[call->data.function_call.function];
+        int passed = call->data.function_call.arg_count;
+        if (passed > func->data.function.param_count) {
+            passed = func->data.function.param_count;
         }
         
-        // Decrement amount (default 1)
-        int amount = 1;
-        if (node->data.unary_op.amount) {
-            Value *amt = eval_node(node->data.unary_op.amount, env);
-            if (amt->type == VAL_INT) {
-                amount = amt->data.int_val;
-            }
-            free_value(amt);
+        for (int i = 0; i < frame.slot_count; i++) {
+            release_value(frame.slots[i]);
+        }
+        memmove(frame.slots, frame.slots + frame.slot_count, sizeof(Value) * passed);
+        slot_count = func->data.function.slot_count;
+        for (int i = passed; i < slot_count; i++) {
+            frame.slots[i].type = VAL_UNDEFINED;
         }
+        call_stack.top += slot_count - frame.slot_count;
+        frame.slot_count = slot_count;
         
-        // Set new value
-        Value *new_val = create_int_value(current->data.int_val - amount);
-        set_variable(env, node->data.unary_op.variable, new_val);
-        free_value(new_val);
+        // Our own caller only ever sees as many values as we passed on
+        if (call->data.function_call.result_count < frame.result_limit) {
+            frame.result_limit = call->data.function_call.result_count;
+        }
+        frame.returning = 0;
+        frame.tail_call = NULL;
     }
     
-    return create_value(VAL_NULL);
+    // Falling off the end returns nothing
+    if (!frame.returning) {
+        for (int i = 0; i < node->data.function_call.result_count; i++) {
+            set_result(env, node, i, null_value());
+        }
+    }
+    
+    for (int i = 0; i < frame.slot_count; i++) {
+        release_value(frame.slots[i]);
+    }
+    call_stack.top -= frame.slot_count;
+    call_stack.depth--;
+    
+    if (call_stack.halted) {
+        env->returning = 1;
+    }
+    return null_value();
+}
+
+// Execute ret a,b,...: values go straight to the caller's result variables;
+// missing ones are null and extra ones are dropped. In .main it ends the program.
+static Value exec_return(ASTNode *node, Environment *env) {
+    int value_count = node->data.return_stmt.value_count;
+    int result_count = env->call ? env->call->data.function_call.result_count : 0;
+    int count = value_count > result_count ? value_count : result_count;
+    
+    for (int i = 0; i < count; i++) {
+        Value value = i < value_count ? eval_node(node->data.return_stmt.values[i], env) : null_value();
+        if (i >= env->result_limit) {
+            release_value(value);
+            value = null_value();
+        }
+        if (i < result_count) {
+            set_result(env->caller, env->call, i, value);
+        } else {
+            release_value(value);
+        }
+    }
+    
+    env->returning = 1;
+    return null_value();
+}
+
+// Execute halt ["message"]: print the message, then unwind every frame
+static Value exec_halt(ASTNode *node, Environment *env) {
+    if (node->data.halt.message) {
+        Value message = eval_node(node->data.halt.message, env);
+        output_value(message);
+        output_char('\n');
+        release_value(message);
+    }
+    
+    call_stack.halted = 1;
+    env->returning = 1;
+    return null_value();
 }
+
+// Execute jmp .label / jeq x,y .label (the resolver found the label)
+static Value exec_jump(ASTNode *node, Environment *env) {
+    int taken = 1;
+    if (node->data.jump.jump_type != TOKEN_JMP) {
+        Value left = eval_node(node->data.jump.left, env);
+        Value right = eval_node(node->data.jump.right, env);
+        taken = compare_values((CompareOp)(node->data.jump.jump_type - TOKEN_JEQ), left, right) > 0;
+        release_value(left);
+        release_value(right);
+    }
+    
+    if (taken) {
+        env->jump = node->data.jump.target;
+    }
+    return null_value();
+}
+
+// Main eval function
+static Value eval_node(ASTNode *node, Environment *env) {
+    if (!node) return null_value();
+    
+    switch (node->type) {
+        case AST_LITERAL_INT:
+        case AST_LITERAL_FLOAT:
+        case AST_LITERAL_STRING:
+        case AST_LITERAL_BOOL:
+            return eval_literal(node);
+        
+        case AST_IDENTIFIER:
+            return eval_identifier(node, env);
+        
+        case AST_BINARY_OP:
+            return eval_binary_op(node, env);
+        
+        case AST_ASSIGNMENT:
+            return exec_assignment(node, env);
+        
+        case AST_ECHO:
+            return exec_echo(node, env);
+        
+        case AST_ARRAY:
+            return exec_array(node, env);
+        
+        case AST_ARRAY_ACCESS:
+            return exec_array_access(node, env);
+        
+        case AST_TYPE_CAST:
+            return exec_type_cast(node, env);
+        
+        case AST_IF_STATEMENT:
+            return exec_if(node, env);
+        
+        case AST_FOR_LOOP:
+            return exec_for(node, env);
+        
+        case AST_WHILE_LOOP:
+            return exec_while(node, env);
+        
+        case AST_UNARY_OP:
+            return exec_unary_op(node, env);
+        
+        case AST_FUNCTION_CALL:
+            return exec_call(node, env);
+        
+        case AST_RETURN:
+            return exec_return(node, env);
+        
+        case AST_JUMP:
+            return exec_jump(node, env);
+        
+        case AST_HALT:
+            return exec_halt(node, env);
+        
+        case AST_BREAK:
+        case AST_CONTINUE:
+            env->breaking = node;
+            return null_value();
+        
+        case AST_LABEL:
+            return null_value();
+        
+        case AST_FUNCTION:
+            // Definitions run only when called
+            return null_value();
         
         default:
-            fprintf(stderr, "Runtime Error: Unimplemented node type %d\n", node->type);
-            return create_value(VAL_NULL);
+            runtime_error("Unimplemented node type %d", node->type);
+            return null_value();
     }
 }
 
 // Main interpreter entry point
 void interpret(ASTNode *ast) {
     if (!ast || ast->type != AST_PROGRAM) {
-        fprintf(stderr, "Runtime Error: Invalid AST\n");
+        runtime_error("Invalid AST");
         return;
     }
     
-    Environment *env = create_environment();
+    call_stack.functions = ast->data.program.functions;
+    call_stack.slots = malloc(sizeof(Value) * CALL_STACK_SLOTS);
+    call_stack.top = 0;
+    call_stack.depth = 0;
+    call_stack.halted = 0;
+    binary_sites = calloc(ast->data.program.site_count, sizeof(BinarySite));
     
-   // Execute all statements
-    for (int i = 0; i < ast->data.program.statement_count; i++) {
-        Value *result = eval_node(ast->data.program.statements[i], env);
-        free_value(result);  // This frees the throwaway null
-    }
+    Environment *env = create_environment(ast->data.program.slot_count);
+    
+    // Execute all statements
+    exec_frame(ast->data.program.statements, ast->data.program.statement_count, env);
     
-    // free_environment(env);
+    free_environment(env);
+    free(call_stack.slots);
+    free(binary_sites);
+    output_flush();
 }
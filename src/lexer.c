@@ -1,103 +1,167 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "lexer.h"
+#include "symbol.h"
+#include "number.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
 
 // Helper: Check if character is valid for identifier
 static int is_identifier_char(char c) {
     return isalnum(c) || c == '_';
 }
 
-// Helper: Check if string is a keyword
-static TokenType check_keyword(const char *str) {
-    // Convert to lowercase for case-insensitive comparison
-    char lower[256];
-    int i = 0;
-    while (str[i] && i < 255) {
-        lower[i] = tolower(str[i]);
-        i++;
+// Helper: Case-insensitive match of an identifier against a lowercase keyword.
+// Folding with | 0x20 only maps letters onto letters, so '_' and digits never match.
+static int keyword_is(const char *str, const char *keyword, int length) {
+    for (int i = 1; i < length; i++) {
+        if ((str[i] | 0x20) != keyword[i]) return 0;
     }
-    lower[i] = '\0';
+    return 1;
+}
 
-    // Keywords (case insensitive)
-    if (strcmp(lower, "start") == 0) return TOKEN_START;
-    if (strcmp(lower, "set") == 0) return TOKEN_SET;
-    if (strcmp(lower, "echo") == 0) return TOKEN_ECHO;
-    if (strcmp(lower, "if") == 0) return TOKEN_IF;
-    if (strcmp(lower, "elseif") == 0) return TOKEN_ELSEIF;
-    if (strcmp(lower, "else") == 0) return TOKEN_ELSE;
-    if (strcmp(lower, "endb") == 0) return TOKEN_ENDB;
-    if (strcmp(lower, "for") == 0) return TOKEN_FOR;
-    if (strcmp(lower, "while") == 0) return TOKEN_WHILE;
-    if (strcmp(lower, "endl") == 0) return TOKEN_ENDL;
-    if (strcmp(lower, "break") == 0) return TOKEN_BREAK;
-    if (strcmp(lower, "continue") == 0) return TOKEN_CONTINUE;
-    if (strcmp(lower, "call") == 0) return TOKEN_CALL;
-    if (strcmp(lower, "ret") == 0) return TOKEN_RET;
-    if (strcmp(lower, "jmp") == 0) return TOKEN_JMP;
-    if (strcmp(lower, "jeq") == 0) return TOKEN_JEQ;
-    if (strcmp(lower, "jne") == 0) return TOKEN_JNE;
-    if (strcmp(lower, "jgt") == 0) return TOKEN_JGT;
-    if (strcmp(lower, "jlt") == 0) return TOKEN_JLT;
-    if (strcmp(lower, "jge") == 0) return TOKEN_JGE;
-    if (strcmp(lower, "jle") == 0) return TOKEN_JLE;
-    if (strcmp(lower, "halt") == 0) return TOKEN_HALT;
-    if (strcmp(lower, "type") == 0) return TOKEN_TYPE;
-    if (strcmp(lower, "int") == 0) return TOKEN_INT_CAST;
-    if (strcmp(lower, "float") == 0) return TOKEN_FLOAT_CAST;
-    if (strcmp(lower, "str") == 0) return TOKEN_STR_CAST;
-    if (strcmp(lower, "bool") == 0) return TOKEN_BOOL_CAST;
-    if (strcmp(lower, "in") == 0) return TOKEN_IN;
-    
-    // Operations
-    if (strcmp(lower, "add") == 0) return TOKEN_ADD;
-    if (strcmp(lower, "sub") == 0) return TOKEN_SUB;
-    if (strcmp(lower, "mul") == 0) return TOKEN_MUL;
-    if (strcmp(lower, "div") == 0) return TOKEN_DIV;
-    if (strcmp(lower, "mod") == 0) return TOKEN_MOD;
-    if (strcmp(lower, "inc") == 0) return TOKEN_INC;
-    if (strcmp(lower, "dec") == 0) return TOKEN_DEC;
-    if (strcmp(lower, "concat") == 0) return TOKEN_CONCAT;
+#define KEYWORD(text, type) if (keyword_is(str, text, length)) return type
+
+// Check if string is a keyword (case insensitive).
+// Dispatches on length and first letter, then confirms with one comparison.
+TokenType lookup_keyword(const char *str, int length) {
+    if (length < 2 || length > 8) return TOKEN_IDENTIFIER;
     
-    // Comparisons
-    if (strcmp(lower, "eq") == 0) return TOKEN_EQ;
-    if (strcmp(lower, "ne") == 0) return TOKEN_NE;
-    if (strcmp(lower, "gt") == 0) return TOKEN_GT;
-    if (strcmp(lower, "lt") == 0) return TOKEN_LT;
-    if (strcmp(lower, "ge") == 0) return TOKEN_GE;
-    if (strcmp(lower, "le") == 0) return TOKEN_LE;
+    char first = str[0] | 0x20;
     
-    // Logical
-    if (strcmp(lower, "and") == 0) return TOKEN_AND;
-    if (strcmp(lower, "or") == 0) return TOKEN_OR;
-    if (strcmp(lower, "not") == 0) return TOKEN_NOT;
+    switch (length) {
+        case 2:
+            switch (first) {
+                case 'e': KEYWORD("eq", TOKEN_EQ); break;
+                case 'g': KEYWORD("gt", TOKEN_GT); KEYWORD("ge", TOKEN_GE); break;
+                case 'i': KEYWORD("if", TOKEN_IF); KEYWORD("in", TOKEN_IN); break;
+                case 'l': KEYWORD("lt", TOKEN_LT); KEYWORD("le", TOKEN_LE); break;
+                case 'n': KEYWORD("ne", TOKEN_NE); break;
+                case 'o': KEYWORD("or", TOKEN_OR); break;
+            }
+            break;
+        
+        case 3:
+            switch (first) {
+                case 'a':
+                    KEYWORD("add", TOKEN_ADD);
+                    KEYWORD("and", TOKEN_AND);
+                    break;
+                case 'd':
+                    KEYWORD("div", TOKEN_DIV);
+                    KEYWORD("dec", TOKEN_DEC);
+                    break;
+                case 'f': KEYWORD("for", TOKEN_FOR); break;
+                case 'i':
+                    KEYWORD("int", TOKEN_INT_CAST);
+                    KEYWORD("inc", TOKEN_INC);
+                    break;
+                case 'j':
+                    KEYWORD("jmp", TOKEN_JMP);
+                    KEYWORD("jeq", TOKEN_JEQ);
+                    KEYWORD("jne", TOKEN_JNE);
+                    KEYWORD("jgt", TOKEN_JGT);
+                    KEYWORD("jlt", TOKEN_JLT);
+                    KEYWORD("jge", TOKEN_JGE);
+                    KEYWORD("jle", TOKEN_JLE);
+                    break;
+                case 'm':
+                    KEYWORD("mul", TOKEN_MUL);
+                    KEYWORD("mod", TOKEN_MOD);
+                    break;
+                case 'n': KEYWORD("not", TOKEN_NOT); break;
+                case 'r': KEYWORD("ret", TOKEN_RET); break;
+                case 's':
+                    KEYWORD("set", TOKEN_SET);
+                    KEYWORD("str", TOKEN_STR_CAST);
+                    KEYWORD("sub", TOKEN_SUB);
+                    break;
+            }
+            break;
+        
+        case 4:
+            switch (first) {
+                case 'b': KEYWORD("bool", TOKEN_BOOL_CAST); break;
+                case 'c': KEYWORD("call", TOKEN_CALL); break;
+                case 'e':
+                    KEYWORD("echo", TOKEN_ECHO);
+                    KEYWORD("else", TOKEN_ELSE);
+                    KEYWORD("endb", TOKEN_ENDB);
+                    KEYWORD("endl", TOKEN_ENDL);
+                    break;
+                case 'h': KEYWORD("halt", TOKEN_HALT); break;
+                case 't':
+                    KEYWORD("type", TOKEN_TYPE);
+                    KEYWORD("true", TOKEN_BOOL_TRUE);
+                    break;
+            }
+            break;
+        
+        case 5:
+            switch (first) {
+                case 'b': KEYWORD("break", TOKEN_BREAK); break;
+                case 'f':
+                    KEYWORD("float", TOKEN_FLOAT_CAST);
+                    KEYWORD("false", TOKEN_BOOL_FALSE);
+                    break;
+                case 's': KEYWORD("start", TOKEN_START); break;
+                case 'w': KEYWORD("while", TOKEN_WHILE); break;
+            }
+            break;
+        
+        case 6:
+            switch (first) {
+                case 'c': KEYWORD("concat", TOKEN_CONCAT); break;
+                case 'e': KEYWORD("elseif", TOKEN_ELSEIF); break;
+            }
+            break;
+        
+        case 8:
+            if (first == 'c') KEYWORD("continue", TOKEN_CONTINUE);
+            break;
+    }
     
-    // Boolean literals (case insensitive)
-    if (strcmp(lower, "true") == 0) return TOKEN_BOOL_TRUE;
-    if (strcmp(lower, "false") == 0) return TOKEN_BOOL_FALSE;
-
     return TOKEN_IDENTIFIER;
 }
 
-// Create token
-Token *create_token(TokenType type, const char *value, int line, int column) {
-    Token *token = malloc(sizeof(Token));
-    token->type = type;
-    token->value = value ? strdup(value) : NULL;
-    token->line = line;
-    token->column = column;
+#undef KEYWORD
+
+// Create token as a slice of the source
+static Token make_token(TokenType type, const char *start, int length, int line, int column) {
+    Token token;
+    token.type = type;
+    token.start = start;
+    token.length = length;
+    token.symbol = NO_SYMBOL;
+    token.line = line;
+    token.column = column;
     return token;
 }
 
-// Free token
-void free_token(Token *token) {
-    if (token) {
-        if (token->value) free(token->value);
-        free(token);
+// Compare token text
+int token_equals(const Token *token, const char *text) {
+    size_t len = strlen(text);
+    return (size_t)token->length == len && memcmp(token->start, text, len) == 0;
+}
+
+// Convert integer token; returns 0 if it does not fit in an int
+int token_int_value(const Token *token, int *value) {
+    long long result = 0;
+    for (int i = 0; i < token->length; i++) {
+        result = result * 10 + (token->start[i] - '0');
+        if (result > INT_MAX) return 0;
     }
+    *value = (int)result;
+    return 1;
+}
+
+// Convert float token
+double token_float_value(const Token *token) {
+    size_t used;
+    return parse_double(token->start, token->length, &used);
 }
 
 // Get token type name (for debugging)
@@ -184,7 +248,7 @@ static void advance(Lexer *lexer) {
     lexer->position++;
     lexer->column++;
     
-    if (lexer->position < strlen(lexer->source)) {
+    if (lexer->position < lexer->length) {
         lexer->current_char = lexer->source[lexer->position];
     } else {
         lexer->current_char = '\0';
@@ -193,13 +257,18 @@ static void advance(Lexer *lexer) {
 
 // Peek at next character without advancing
 static char peek(Lexer *lexer) {
-    int peek_pos = lexer->position + 1;
-    if (peek_pos < strlen(lexer->source)) {
+    size_t peek_pos = lexer->position + 1;
+    if (peek_pos < lexer->length) {
         return lexer->source[peek_pos];
     }
     return '\0';
 }
 
+// The source is a length-delimited slice, so a NUL byte is ordinary input
+static int at_end(Lexer *lexer) {
+    return lexer->position >= lexer->length;
+}
+
 // Skip whitespace (but not newlines)
 static void skip_whitespace(Lexer *lexer) {
     while (lexer->current_char == ' ' || 
@@ -211,7 +280,7 @@ static void skip_whitespace(Lexer *lexer) {
 
 // Skip single-line comment
 static void skip_line_comment(Lexer *lexer) {
-    while (lexer->current_char != '\n' && lexer->current_char != '\0') {
+    while (lexer->current_char != '\n' && !at_end(lexer)) {
         advance(lexer);
     }
 }
@@ -221,7 +290,7 @@ static void skip_block_comment(Lexer *lexer) {
     advance(lexer); // skip '/'
     advance(lexer); // skip '*'
     
-    while (lexer->current_char != '\0') {
+    while (!at_end(lexer)) {
         if (lexer->current_char == '*' && peek(lexer) == '/') {
             advance(lexer); // skip '*'
             advance(lexer); // skip '/'
@@ -232,10 +301,9 @@ static void skip_block_comment(Lexer *lexer) {
 }
 
 // Read a number (int or float)
-static Token *read_number(Lexer *lexer) {
+static Token read_number(Lexer *lexer) {
     int start_col = lexer->column;
-    char buffer[256];
-    int i = 0;
+    size_t start = lexer->position;
     int is_float = 0;
     
     while (isdigit(lexer->current_char) || lexer->current_char == '.') {
@@ -245,83 +313,80 @@ static Token *read_number(Lexer *lexer) {
             if (peek(lexer) == '.') break;
             is_float = 1;
         }
-        buffer[i++] = lexer->current_char;
         advance(lexer);
     }
-    buffer[i] = '\0';
     
-    return create_token(is_float ? TOKEN_FLOAT : TOKEN_INT, buffer, lexer->line, start_col);
+    return make_token(is_float ? TOKEN_FLOAT : TOKEN_INT, lexer->source + start,
+                      (int)(lexer->position - start), lexer->line, start_col);
 }
 
-// Read a string (with quotes)
-static Token *read_string(Lexer *lexer) {
+// Read a string (with quotes); the slice excludes the quotes but keeps escapes
+static Token read_string(Lexer *lexer) {
     int start_col = lexer->column;
-    char buffer[1024];
-    int i = 0;
     
     advance(lexer); // skip opening quote
+    size_t start = lexer->position;
     
-    while (lexer->current_char != '"' && lexer->current_char != '\0') {
+    while (lexer->current_char != '"' && !at_end(lexer)) {
         if (lexer->current_char == '\\' && peek(lexer) == '"') {
             advance(lexer); // skip backslash
-            buffer[i++] = '"';
-            advance(lexer);
-        } else {
-            buffer[i++] = lexer->current_char;
-            advance(lexer);
         }
+        advance(lexer);
     }
     
+    size_t end = lexer->position;
     if (lexer->current_char == '"') {
         advance(lexer); // skip closing quote
     }
     
-    buffer[i] = '\0';
-    return create_token(TOKEN_STRING, buffer, lexer->line, start_col);
+    return make_token(TOKEN_STRING, lexer->source + start, (int)(end - start),
+                      lexer->line, start_col);
 }
 
 // Read an identifier or keyword
-static Token *read_identifier(Lexer *lexer) {
+static Token read_identifier(Lexer *lexer) {
     int start_col = lexer->column;
-    char buffer[256];
-    int i = 0;
+    size_t start = lexer->position;
     
     while (is_identifier_char(lexer->current_char)) {
-        buffer[i++] = lexer->current_char;
         advance(lexer);
     }
-    buffer[i] = '\0';
     
-    TokenType type = check_keyword(buffer);
-    return create_token(type, buffer, lexer->line, start_col);
+    int length = (int)(lexer->position - start);
+    TokenType type = lookup_keyword(lexer->source + start, length);
+    Token token = make_token(type, lexer->source + start, length, lexer->line, start_col);
+    if (type == TOKEN_IDENTIFIER) {
+        token.symbol = intern_symbol(token.start, length);
+    }
+    return token;
 }
 
 // Read a label (.labelname or .function)
-static Token *read_label(Lexer *lexer) {
+static Token read_label(Lexer *lexer) {
     int start_col = lexer->column;
-    char buffer[256];
-    int i = 0;
+    size_t start = lexer->position;
     
-    buffer[i++] = lexer->current_char; // include the dot
-    advance(lexer);
+    advance(lexer); // include the dot
     
     while (is_identifier_char(lexer->current_char)) {
-        buffer[i++] = lexer->current_char;
         advance(lexer);
     }
-    buffer[i] = '\0';
     
-    return create_token(TOKEN_LABEL, buffer, lexer->line, start_col);
+    Token token = make_token(TOKEN_LABEL, lexer->source + start, (int)(lexer->position - start),
+                             lexer->line, start_col);
+    token.symbol = intern_symbol(token.start, token.length);
+    return token;
 }
 
 // Create lexer
-Lexer *create_lexer(const char *source) {
+Lexer *create_lexer(const char *source, size_t length) {
     Lexer *lexer = malloc(sizeof(Lexer));
     lexer->source = source;
+    lexer->length = length;
     lexer->position = 0;
     lexer->line = 1;
     lexer->column = 0;
-    lexer->current_char = source[0];
+    lexer->current_char = length > 0 ? source[0] : '\0';
     return lexer;
 }
 
@@ -333,9 +398,10 @@ void free_lexer(Lexer *lexer) {
 }
 
 // Get next token
-Token *get_next_token(Lexer *lexer) {
-    while (lexer->current_char != '\0') {
+Token get_next_token(Lexer *lexer) {
+    while (!at_end(lexer)) {
         int start_col = lexer->column;
+        const char *start = lexer->source + lexer->position;
         
         // Skip whitespace
         if (lexer->current_char == ' ' || 
@@ -348,7 +414,7 @@ Token *get_next_token(Lexer *lexer) {
         // Newline
         if (lexer->current_char == '\n') {
             advance(lexer);
-            return create_token(TOKEN_NEWLINE, "\\n", lexer->line - 1, start_col);
+            return make_token(TOKEN_NEWLINE, start, 1, lexer->line - 1, start_col);
         }
         
         // Comments
@@ -382,48 +448,48 @@ Token *get_next_token(Lexer *lexer) {
             advance(lexer);
             advance(lexer);
             advance(lexer);
-            return create_token(TOKEN_ELLIPSIS, "...", lexer->line, start_col);
+            return make_token(TOKEN_ELLIPSIS, start, 3, lexer->line, start_col);
         }
         
         // Single character tokens
         switch (lexer->current_char) {
             case ',':
                 advance(lexer);
-                return create_token(TOKEN_COMMA, ",", lexer->line, start_col);
+                return make_token(TOKEN_COMMA, start, 1, lexer->line, start_col);
             case '.':
                 advance(lexer);
-                return create_token(TOKEN_DOT, ".", lexer->line, start_col);
+                return make_token(TOKEN_DOT, start, 1, lexer->line, start_col);
             case '(':
                 advance(lexer);
-                return create_token(TOKEN_LPAREN, "(", lexer->line, start_col);
+                return make_token(TOKEN_LPAREN, start, 1, lexer->line, start_col);
             case ')':
                 advance(lexer);
-                return create_token(TOKEN_RPAREN, ")", lexer->line, start_col);
+                return make_token(TOKEN_RPAREN, start, 1, lexer->line, start_col);
             case '{':
                 advance(lexer);
-                return create_token(TOKEN_LBRACE, "{", lexer->line, start_col);
+                return make_token(TOKEN_LBRACE, start, 1, lexer->line, start_col);
             case '}':
                 advance(lexer);
-                return create_token(TOKEN_RBRACE, "}", lexer->line, start_col);
+                return make_token(TOKEN_RBRACE, start, 1, lexer->line, start_col);
             case '[':
                 advance(lexer);
-                return create_token(TOKEN_LBRACKET, "[", lexer->line, start_col);
+                return make_token(TOKEN_LBRACKET, start, 1, lexer->line, start_col);
             case ']':
                 advance(lexer);
-                return create_token(TOKEN_RBRACKET, "]", lexer->line, start_col);
+                return make_token(TOKEN_RBRACKET, start, 1, lexer->line, start_col);
             case ':':
                 advance(lexer);
-                return create_token(TOKEN_COLON, ":", lexer->line, start_col);
+                return make_token(TOKEN_COLON, start, 1, lexer->line, start_col);
             case '_':
                 // Check if it's a loop label (_loopname) or just underscore
                 if (isalpha(peek(lexer))) {
                     return read_identifier(lexer); // Will be an identifier starting with _
                 }
                 advance(lexer);
-                return create_token(TOKEN_UNDERSCORE, "_", lexer->line, start_col);
+                return make_token(TOKEN_UNDERSCORE, start, 1, lexer->line, start_col);
             case '$':
                 advance(lexer);
-                return create_token(TOKEN_DOLLAR, "$", lexer->line, start_col);
+                return make_token(TOKEN_DOLLAR, start, 1, lexer->line, start_col);
         }
         
         // Identifiers and keywords
@@ -432,25 +498,28 @@ Token *get_next_token(Lexer *lexer) {
         }
         
         // Unknown character
-        char unknown[2] = {lexer->current_char, '\0'};
         advance(lexer);
-        return create_token(TOKEN_ERROR, unknown, lexer->line, start_col);
+        return make_token(TOKEN_ERROR, start, 1, lexer->line, start_col);
     }
     
-    return create_token(TOKEN_EOF, "", lexer->line, lexer->column);
+    return make_token(TOKEN_EOF, lexer->source + lexer->position, 0, lexer->line, lexer->column);
 }
 
-// Tokenize entire source
-Token **tokenize(const char *source, int *token_count) {
-    Lexer *lexer = create_lexer(source);
-    Token **tokens = malloc(sizeof(Token*) * 10000); // Initial capacity
+// Tokenize entire source into a contiguous, growable token buffer
+Token *tokenize(const char *source, size_t length, int *token_count) {
+    Lexer *lexer = create_lexer(source, length);
+    int capacity = 1024;
     int count = 0;
+    Token *tokens = malloc(sizeof(Token) * capacity);
     
-    Token *token;
-    while ((token = get_next_token(lexer))->type != TOKEN_EOF) {
-        tokens[count++] = token;
+    while (1) {
+        if (count == capacity) {
+            capacity *= 2;
+            tokens = realloc(tokens, sizeof(Token) * capacity);
+        }
+        tokens[count] = get_next_token(lexer);
+        if (tokens[count++].type == TOKEN_EOF) break; // Include EOF token
     }
-    tokens[count++] = token; // Include EOF token
     
     *token_count = count;
     free_lexer(lexer);
@@ -2,26 +2,31 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include <stddef.h>
 #include "token.h"
 
 typedef struct {
     const char *source;   // Source code
-    int position;         // Current position
+    size_t length;        // Source length (measured once)
+    size_t position;      // Current position
     int line;             // Current line
     int column;           // Current column
     char current_char;    // Current character
 } Lexer;
 
-// Initialize lexer
-Lexer *create_lexer(const char *source);
+// Initialize lexer (source need not be NUL-terminated)
+Lexer *create_lexer(const char *source, size_t length);
 
 // Free lexer
 void free_lexer(Lexer *lexer);
 
 // Get next token
-Token *get_next_token(Lexer *lexer);
+Token get_next_token(Lexer *lexer);
 
-// Tokenize entire source (returns array of tokens)
-Token **tokenize(const char *source, int *token_count);
+// Classify an identifier slice as a keyword (case insensitive)
+TokenType lookup_keyword(const char *str, int length);
+
+// Tokenize entire source (returns a contiguous token array; free() when done)
+Token *tokenize(const char *source, size_t length, int *token_count);
 
 #endif
@@ -0,0 +1,126 @@
+#include "linker.h"
+#include "symbol.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Function index by name symbol (-1 if undefined) and errors so far
+typedef struct {
+    int *index_of;
+    int errors;
+    int in_function;
+} Linker;
+
+static void link_node(Linker *linker, ASTNode *node);
+
+// call .f(...) eq a,b followed by ret a,b hands f's results straight to our
+// caller, so the call can reuse the current frame
+static int is_tail_call(ASTNode *call, ASTNode *next) {
+    if (!next || next->type != AST_RETURN) return 0;
+    
+    int count = call->data.function_call.result_count;
+    int *results = call->data.function_call.result_vars;
+    if (next->data.return_stmt.value_count != count) return 0;
+    
+    for (int i = 0; i < count; i++) {
+        ASTNode *value = next->data.return_stmt.values[i];
+        if (value->type != AST_IDENTIFIER || value->data.identifier.name.symbol != results[i]) {
+            return 0;
+        }
+        // eq a,a keeps only the last value, which a tail call cannot mimic
+        for (int j = 0; j < i; j++) {
+            if (results[j] == results[i]) return 0;
+        }
+    }
+    return 1;
+}
+
+static void link_block(Linker *linker, ASTNode **body, int count) {
+    for (int i = 0; i < count; i++) {
+        link_node(linker, body[i]);
+        if (linker->in_function && body[i]->type == AST_FUNCTION_CALL) {
+            body[i]->data.function_call.tail = is_tail_call(body[i], i + 1 < count ? body[i + 1] : NULL);
+        }
+    }
+}
+
+// Calls are statements, so only statement lists need walking
+static void link_node(Linker *linker, ASTNode *node) {
+    if (!node) return;
+    
+    switch (node->type) {
+        case AST_FUNCTION_CALL: {
+            int name = node->data.function_call.function_name;
+            node->data.function_call.function = linker->index_of[name];
+            if (linker->index_of[name] < 0) {
+                fprintf(stderr, "Link Error [%d:%d]: Undefined function '%s'\n",
+                        node->line, node->column, symbol_name(name));
+                linker->errors++;
+            }
+            break;
+        }
+        
+        case AST_IF_STATEMENT:
+            link_block(linker, node->data.if_stmt.then_body, node->data.if_stmt.then_count);
+            link_block(linker, node->data.if_stmt.else_body, node->data.if_stmt.else_count);
+            break;
+        
+        case AST_FOR_LOOP:
+            link_block(linker, node->data.for_loop.body, node->data.for_loop.body_count);
+            break;
+        
+        case AST_WHILE_LOOP:
+            link_block(linker, node->data.while_loop.body, node->data.while_loop.body_count);
+            break;
+        
+        case AST_FUNCTION:
+            linker->in_function = 1;
+            link_block(linker, node->data.function.body, node->data.function.body_count);
+            linker->in_function = 0;
+            break;
+        
+        default:
+            break;
+    }
+}
+
+int link_program(ASTNode *program, Arena *arena) {
+    ASTNode **statements = program->data.program.statements;
+    int count = program->data.program.statement_count;
+    
+    Linker linker;
+    linker.errors = 0;
+    linker.in_function = 0;
+    linker.index_of = malloc(sizeof(int) * (symbol_count() + 1));
+    for (int i = 0; i <= symbol_count(); i++) {
+        linker.index_of[i] = -1;
+    }
+    
+    // Function table, in definition order
+    int function_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (statements[i]->type == AST_FUNCTION) function_count++;
+    }
+    ASTNode **functions = function_count ? arena_alloc(arena, sizeof(ASTNode*) * function_count) : NULL;
+    
+    function_count = 0;
+    for (int i = 0; i < count; i++) {
+        ASTNode *func = statements[i];
+        if (func->type != AST_FUNCTION) continue;
+        
+        int name = func->data.function.name;
+        if (linker.index_of[name] >= 0) {
+            fprintf(stderr, "Link Error [%d:%d]: Function '%s' is already defined\n",
+                    func->line, func->column, symbol_name(name));
+            linker.errors++;
+        }
+        linker.index_of[name] = function_count;
+        functions[function_count++] = func;
+    }
+    program->data.program.functions = functions;
+    program->data.program.function_count = function_count;
+    
+    link_block(&linker, statements, count);
+    
+    free(linker.index_of);
+    return linker.errors;
+}
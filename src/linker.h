@@ -0,0 +1,15 @@
+#ifndef LINKER_H
+#define LINKER_H
+
+#include "ast.h"
+#include "arena.h"
+
+// Linker pass (runs right after parsing).
+// Collects the function definitions into program.functions and points every
+// call at its callee's index there, so no call looks a function up by name
+// at runtime. Calls to undefined functions and duplicate definitions are
+// reported here; returns the number of errors (nothing may run if non-zero).
+// Calls in tail position (call ... eq r followed by ret r) are marked too.
+int link_program(ASTNode *program, Arena *arena);
+
+#endif
@@ -1,54 +1,166 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "lexer.h"
 #include "parser.h"
 #include "interpreter.h"
 #include "token.h"
 #include "ast.h"
+#include "symbol.h"
+#include "resolver.h"
+#include "linker.h"
+#include "optimizer.h"
+#include "compiler.h"
+#include "vm.h"
+#include "output.h"
+
+// Loaded source text: mapped read-only from a file, or read into a buffer
+typedef struct {
+    char *data;
+    size_t length;
+    int mapped;
+} SourceFile;
+
+// Read everything from a descriptor that cannot be mapped (stdin, pipes)
+static int read_stream(int fd, SourceFile *source) {
+    size_t capacity = 64 * 1024;
+    size_t length = 0;
+    char *data = malloc(capacity);
+
+    while (1) {
+        if (length == capacity) {
+            capacity *= 2;
+            data = realloc(data, capacity);
+        }
+        ssize_t n = read(fd, data + length, capacity - length);
+        if (n < 0) {
+            free(data);
+            return 0;
+        }
+        if (n == 0) break;
+        length += n;
+    }
+
+    source->data = data;
+    source->length = length;
+    source->mapped = 0;
+    return 1;
+}
+
+// Map a regular file, falling back to buffered reads for anything else
+static int load_source(const char *path, SourceFile *source) {
+    if (strcmp(path, "-") == 0) {
+        return read_stream(STDIN_FILENO, source);
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            posix_madvise(data, st.st_size, POSIX_MADV_SEQUENTIAL);
+            close(fd);
+            source->data = data;
+            source->length = st.st_size;
+            source->mapped = 1;
+            return 1;
+        }
+    }
+
+    int ok = read_stream(fd, source);
+    close(fd);
+    return ok;
+}
+
+static void release_source(SourceFile *source) {
+    if (source->mapped) {
+        munmap(source->data, source->length);
+    } else {
+        free(source->data);
+    }
+}
 
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <filename.ratio>\n", argv[0]);
-        return 1;
+    // Options: --ast runs the tree-walking interpreter instead of the VM,
+    // -O<level> picks the AST optimisation level (-O0 turns it off),
+    // --unbuffered writes program output line by line
+    int use_ast = 0;
+    int opt_level = OPT_FOLD;
+    const char *path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ast") == 0) {
+            use_ast = 1;
+        } else if (strcmp(argv[i], "--unbuffered") == 0) {
+            output_set_unbuffered(1);
+        } else if (strncmp(argv[i], "-O", 2) == 0) {
+            opt_level = argv[i][2] ? atoi(argv[i] + 2) : OPT_FOLD;
+        } else {
+            path = argv[i];
+        }
     }
 
-    // Read source file
-    FILE *file = fopen(argv[1], "r");
-    if (!file) {
-        fprintf(stderr, "Error: Cannot open file '%s'\n", argv[1]);
+    if (!path) {
+        fprintf(stderr, "Usage: %s [--ast] [--unbuffered] [-O<level>] <filename.ratio | ->\n", argv[0]);
         return 1;
     }
 
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
+    // Load source file
+    SourceFile source;
+    if (!load_source(path, &source)) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", path);
+        return 1;
+    }
 
-    char *source = malloc(file_size + 1);
-    fread(source, 1, file_size, file);
-    source[file_size] = '\0';
-    fclose(file);
+    // Runtime errors can exit mid-program; keep the output produced so far
+    atexit(output_flush);
 
     printf("=== RATIO INTERPRETER v1.0 ===\n\n");
 
-    // Tokenize
-    int token_count = 0;
-    Token **tokens = tokenize(source, &token_count);
+    // Parse (tokens are lexed on demand, straight from the source)
+    Arena *arena = create_arena(64 * 1024);
+    ASTNode *ast = parse_source(source.data, source.length, arena);
+
+    // Point calls at their functions; nothing runs if any are missing
+    if (link_program(ast, arena) > 0) {
+        free_arena(arena);
+        free_symbols();
+        release_source(&source);
+        return 1;
+    }
+
+    // Fold constants and prune dead code
+    optimize(ast, arena, opt_level);
 
-    // Parse
-    ASTNode *ast = parse(tokens, token_count);
+    // Assign variables to frame slots and jumps to labels
+    if (resolve(ast, arena) > 0) {
+        free_arena(arena);
+        free_symbols();
+        release_source(&source);
+        return 1;
+    }
 
-    // Interpret!
+    // Run: compile to bytecode, or walk the tree
     printf("=== OUTPUT ===\n");
-    interpret(ast);
+    if (use_ast) {
+        interpret(ast);
+    } else {
+        Proto *proto = compile(ast);
+        vm_run(proto);
+        free_proto(proto);
+    }
 
     // Cleanup
-    for (int i = 0; i < token_count; i++) {
-        free_token(tokens[i]);
-    }
-    free(tokens);
-    free_ast_node(ast);
-    free(source);
+    free_arena(arena);
+    free_symbols();
+    release_source(&source);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,425 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "number.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// ==================== FORMATTING (GRISU3) ====================
+
+// A double as an unnormalised binary float: f * 2^e
+typedef struct {
+    uint64_t f;
+    int e;
+} DiyFp;
+
+#define SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFULL
+#define HIDDEN_BIT 0x0010000000000000ULL
+#define EXPONENT_BIAS 1075      // 0x3FF + 52
+
+// 10^k for k = -348, -340, ..., 340, normalised to 64-bit significands
+static const uint64_t cached_powers_f[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+
+static const int16_t cached_powers_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066,
+};
+
+static const uint32_t pow10_32[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static DiyFp diy_from_double(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int biased_e = (int)((bits >> 52) & 0x7FF);
+    uint64_t significand = bits & SIGNIFICAND_MASK;
+    
+    DiyFp v;
+    if (biased_e != 0) {
+        v.f = significand + HIDDEN_BIT;
+        v.e = biased_e - EXPONENT_BIAS;
+    } else {
+        v.f = significand;
+        v.e = 1 - EXPONENT_BIAS;
+    }
+    return v;
+}
+
+// Upper 64 bits of the 128-bit product, rounded
+static DiyFp diy_multiply(DiyFp x, DiyFp y) {
+    const uint64_t mask = 0xFFFFFFFFULL;
+    uint64_t a = x.f >> 32, b = x.f & mask;
+    uint64_t c = y.f >> 32, d = y.f & mask;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & mask) + (bc & mask);
+    tmp += 1ULL << 31;
+    DiyFp r = { ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64 };
+    return r;
+}
+
+static DiyFp diy_normalize(DiyFp v) {
+    while (!(v.f & (1ULL << 63))) {
+        v.f <<= 1;
+        v.e--;
+    }
+    return v;
+}
+
+// The halfway points to the neighbouring doubles, on a shared exponent
+static void diy_boundaries(DiyFp v, DiyFp *minus, DiyFp *plus) {
+    DiyFp p = { (v.f << 1) + 1, v.e - 1 };
+    while (!(p.f & (HIDDEN_BIT << 1))) {
+        p.f <<= 1;
+        p.e--;
+    }
+    p.f <<= 10;
+    p.e -= 10;
+    
+    DiyFp m;
+    if (v.f == HIDDEN_BIT) {
+        m.f = (v.f << 2) - 1;
+        m.e = v.e - 2;
+    } else {
+        m.f = (v.f << 1) - 1;
+        m.e = v.e - 1;
+    }
+    m.f <<= m.e - p.e;
+    m.e = p.e;
+    
+    *minus = m;
+    *plus = p;
+}
+
+// Cached power c = 10^-K that brings e into the digit generation range
+static DiyFp cached_power(int e, int *K) {
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = (int)dk;
+    if (dk - k > 0.0) k++;
+    int index = (k >> 3) + 1;
+    *K = -(-348 + index * 8);
+    DiyFp c = { cached_powers_f[index], cached_powers_e[index] };
+    return c;
+}
+
+static int count_digits(uint32_t n) {
+    int digits = 1;
+    while (digits < 10 && n >= pow10_32[digits]) digits++;
+    return digits;
+}
+
+// Nudge the last digit towards the exact value while staying in range, then
+// report whether the digits are provably the shortest closest ones. The
+// scaled boundaries are each off by up to one unit, so anything within a
+// unit of a decision point is left to the exact fallback.
+static int round_weed(char *digits, int length, uint64_t distance_high_w,
+                      uint64_t unsafe_interval, uint64_t rest, uint64_t ten_kappa,
+                      uint64_t unit) {
+    uint64_t small_distance = distance_high_w - unit;
+    uint64_t big_distance = distance_high_w + unit;
+    while (rest < small_distance && unsafe_interval - rest >= ten_kappa &&
+           (rest + ten_kappa < small_distance ||
+            small_distance - rest >= rest + ten_kappa - small_distance)) {
+        digits[length - 1]--;
+        rest += ten_kappa;
+    }
+    if (rest < big_distance && unsafe_interval - rest >= ten_kappa &&
+        (rest + ten_kappa < big_distance ||
+         big_distance - rest > rest + ten_kappa - big_distance)) {
+        return 0;
+    }
+    return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+// Generate the fewest digits that stay inside (low, high). Returns the digit
+// count, or 0 when the result cannot be proven shortest and closest.
+static int digit_gen(DiyFp low, DiyFp W, DiyFp high, char *digits, int *K) {
+    uint64_t unit = 1;
+    DiyFp too_high = { high.f + unit, high.e };
+    uint64_t unsafe_interval = too_high.f - (low.f - unit);
+    DiyFp one = { 1ULL << -W.e, W.e };
+    uint32_t integrals = (uint32_t)(too_high.f >> -one.e);
+    uint64_t fractionals = too_high.f & (one.f - 1);
+    int kappa = count_digits(integrals);
+    int length = 0;
+    
+    while (kappa > 0) {
+        uint32_t d = integrals / pow10_32[kappa - 1];
+        integrals %= pow10_32[kappa - 1];
+        if (d || length) digits[length++] = (char)('0' + d);
+        kappa--;
+        uint64_t rest = ((uint64_t)integrals << -one.e) + fractionals;
+        if (rest < unsafe_interval) {
+            *K += kappa;
+            if (!round_weed(digits, length, too_high.f - W.f, unsafe_interval, rest,
+                            (uint64_t)pow10_32[kappa] << -one.e, unit)) {
+                return 0;
+            }
+            return length;
+        }
+    }
+    
+    for (;;) {
+        fractionals *= 10;
+        unit *= 10;
+        unsafe_interval *= 10;
+        char d = (char)(fractionals >> -one.e);
+        if (d || length) digits[length++] = (char)('0' + d);
+        fractionals &= one.f - 1;
+        kappa--;
+        if (fractionals < unsafe_interval) {
+            *K += kappa;
+            if (!round_weed(digits, length, (too_high.f - W.f) * unit, unsafe_interval,
+                            fractionals, one.f, unit)) {
+                return 0;
+            }
+            return length;
+        }
+    }
+}
+
+// Digits of a positive finite double: value = digits * 10^K, or 0 when
+// Grisu3 cannot decide them
+static int grisu3(double value, char *digits, int *K) {
+    DiyFp v = diy_from_double(value);
+    DiyFp w_minus, w_plus;
+    diy_boundaries(v, &w_minus, &w_plus);
+    
+    DiyFp c = cached_power(w_plus.e, K);
+    DiyFp W = diy_multiply(diy_normalize(v), c);
+    DiyFp Wp = diy_multiply(w_plus, c);
+    DiyFp Wm = diy_multiply(w_minus, c);
+    return digit_gen(Wm, W, Wp, digits, K);
+}
+
+// The rare values Grisu3 rejects. printf's digits are correctly rounded, and
+// 15 of them always name a double exactly when any 15 or fewer do, so the
+// first precision from 15 up that reads back gives the shortest closest digits.
+static int exact_digits(double value, char *digits, int *K) {
+    char text[40];
+    for (int precision = 15; precision <= 17; precision++) {
+        snprintf(text, sizeof(text), "%.*e", precision - 1, value);
+        if (strtod(text, NULL) != value && precision < 17) continue;
+        
+        // d.ddddde[+-]x
+        int length = 0;
+        const char *p = text;
+        for (; *p != 'e'; p++) {
+            if (*p != '.') digits[length++] = *p;
+        }
+        int exponent = atoi(p + 1);
+        while (length > 1 && digits[length - 1] == '0') length--;
+        *K = exponent - (length - 1);
+        return length;
+    }
+    return 0;
+}
+
+int format_double(double value, char *text) {
+    char *p = text;
+    if (isnan(value)) {
+        memcpy(text, "nan", 4);
+        return 3;
+    }
+    if (signbit(value)) {
+        *p++ = '-';
+        value = -value;
+    }
+    if (isinf(value)) {
+        memcpy(p, "inf", 4);
+        return (int)(p - text) + 3;
+    }
+    if (value == 0.0) {
+        memcpy(p, "0.0", 4);
+        return (int)(p - text) + 3;
+    }
+    
+    char digits[20];
+    int K;
+    int length = grisu3(value, digits, &K);
+    if (length == 0) {
+        length = exact_digits(value, digits, &K);
+    }
+    int point = length + K;         // digits before the decimal point
+    
+    if (point > -4 && point <= 16) {
+        if (K >= 0) {
+            // 1234500.0
+            memcpy(p, digits, length);
+            p += length;
+            memset(p, '0', K);
+            p += K;
+            memcpy(p, ".0", 2);
+            p += 2;
+        } else if (point > 0) {
+            // 12.345
+            memcpy(p, digits, point);
+            p += point;
+            *p++ = '.';
+            memcpy(p, digits + point, length - point);
+            p += length - point;
+        } else {
+            // 0.0012345
+            *p++ = '0';
+            *p++ = '.';
+            memset(p, '0', -point);
+            p += -point;
+            memcpy(p, digits, length);
+            p += length;
+        }
+    } else {
+        // 1.2345e+20, 1e-07
+        *p++ = digits[0];
+        if (length > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, length - 1);
+            p += length - 1;
+        }
+        int exponent = point - 1;
+        *p++ = 'e';
+        *p++ = exponent < 0 ? '-' : '+';
+        if (exponent < 0) exponent = -exponent;
+        if (exponent >= 100) {
+            *p++ = (char)('0' + exponent / 100);
+            exponent %= 100;
+        }
+        *p++ = (char)('0' + exponent / 10);
+        *p++ = (char)('0' + exponent % 10);
+    }
+    
+    *p = '\0';
+    return (int)(p - text);
+}
+
+// ==================== PARSING ====================
+
+// Powers of ten that are exact doubles
+static const double exact_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// strtod() on a copy, for text the fast path can't take exactly
+static double parse_slow(const char *text, size_t length, size_t *used) {
+    char small[64];
+    char *copy = length < sizeof(small) ? small : malloc(length + 1);
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    
+    char *end;
+    double value = strtod(copy, &end);
+    *used = (size_t)(end - copy);
+    if (copy != small) free(copy);
+    return value;
+}
+
+double parse_double(const char *text, size_t length, size_t *used) {
+    size_t i = 0;
+    int negative = 0;
+    if (i < length && (text[i] == '-' || text[i] == '+')) {
+        negative = (text[i] == '-');
+        i++;
+    }
+    
+    // Up to 19 significant digits fit the accumulator
+    uint64_t mantissa = 0;
+    int digit_count = 0;
+    int exponent = 0;
+    size_t digits_start = i;
+    while (i < length && text[i] >= '0' && text[i] <= '9') {
+        if (digit_count < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(text[i] - '0');
+            if (mantissa) digit_count++;
+        } else {
+            exponent++;
+            digit_count++;
+        }
+        i++;
+    }
+    size_t int_digits = i - digits_start;
+    size_t frac_digits = 0;
+    if (i < length && text[i] == '.') {
+        i++;
+        size_t frac_start = i;
+        while (i < length && text[i] >= '0' && text[i] <= '9') {
+            if (digit_count < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(text[i] - '0');
+                if (mantissa) digit_count++;
+                exponent--;
+            } else {
+                digit_count++;
+            }
+            i++;
+        }
+        frac_digits = i - frac_start;
+    }
+    if (int_digits + frac_digits == 0 || (i < length && (text[i] == 'x' || text[i] == 'X'))) {
+        return parse_slow(text, length, used);      // inf, nan, hex
+    }
+    
+    if (i < length && (text[i] == 'e' || text[i] == 'E')) {
+        size_t j = i + 1;
+        int exp_negative = 0;
+        if (j < length && (text[j] == '-' || text[j] == '+')) {
+            exp_negative = (text[j] == '-');
+            j++;
+        }
+        if (j < length && text[j] >= '0' && text[j] <= '9') {
+            int value = 0;
+            while (j < length && text[j] >= '0' && text[j] <= '9') {
+                if (value < 100000) value = value * 10 + (text[j] - '0');
+                j++;
+            }
+            exponent += exp_negative ? -value : value;
+            i = j;
+        }
+    }
+    
+    // Exact when both the digits and the power of ten are exact doubles:
+    // one correctly rounded multiply or divide then gives the right answer
+    if (digit_count <= 19 && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        double value = (double)mantissa;
+        value = exponent < 0 ? value / exact_pow10[-exponent] : value * exact_pow10[exponent];
+        *used = i;
+        return negative ? -value : value;
+    }
+    return parse_slow(text, length, used);
+}
@@ -0,0 +1,22 @@
+#ifndef NUMBER_H
+#define NUMBER_H
+
+#include <stddef.h>
+
+// Float <-> text conversions shared by the lexer, str casts and echo.
+// Both directions are exact and locale-independent.
+
+// Room for the longest text format_double() writes, including the NUL
+#define DOUBLE_TEXT_SIZE 32
+
+// Shortest text that reads back as the same double: 1.5, 3.0, 0.1,
+// 1e+16, 2.5e-07, -0.0, inf, nan. Plain decimals are used for exponents
+// -4..15, scientific notation outside that. Returns the length.
+int format_double(double value, char *text);
+
+// Parse a decimal float from text[0..length): [sign] digits [. digits]
+// [e [sign] digits], plus anything strtod() accepts. Sets *used to the
+// number of characters consumed (0 if there is no number).
+double parse_double(const char *text, size_t length, size_t *used);
+
+#endif
@@ -0,0 +1,394 @@
+#include "optimizer.h"
+#include "value.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+// Statement list being rebuilt
+typedef struct {
+    ASTNode **items;
+    int count;
+    int capacity;
+} NodeList;
+
+static void node_list_push(NodeList *list, ASTNode *node) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 8;
+        list->items = realloc(list->items, sizeof(ASTNode*) * list->capacity);
+    }
+    list->items[list->count++] = node;
+}
+
+// ==================== LITERALS ====================
+
+static int is_literal(ASTNode *node) {
+    return node && (node->type == AST_LITERAL_INT || node->type == AST_LITERAL_FLOAT ||
+                    node->type == AST_LITERAL_STRING || node->type == AST_LITERAL_BOOL);
+}
+
+// Literal node -> Value (strings borrow the node's text)
+static Value literal_value(ASTNode *node) {
+    switch (node->type) {
+        case AST_LITERAL_INT: return int_value(node->data.int_literal.value);
+        case AST_LITERAL_FLOAT: return float_value(node->data.float_literal.value);
+        case AST_LITERAL_BOOL: return bool_value(node->data.bool_literal.value);
+        default: return string_value_n(node->data.string_literal.value, node->data.string_literal.length);
+    }
+}
+
+// Value -> literal node, or NULL for values with no literal form
+static ASTNode *make_literal(Arena *arena, ASTNode *at, Value val) {
+    ASTNode *node;
+    switch (val.type) {
+        case VAL_INT:
+            node = create_ast_node(arena, AST_LITERAL_INT, at->line, at->column);
+            node->data.int_literal.value = val.data.int_val;
+            return node;
+        case VAL_FLOAT:
+            node = create_ast_node(arena, AST_LITERAL_FLOAT, at->line, at->column);
+            node->data.float_literal.value = val.data.float_val;
+            return node;
+        case VAL_BOOL:
+            node = create_ast_node(arena, AST_LITERAL_BOOL, at->line, at->column);
+            node->data.bool_literal.value = val.data.bool_val;
+            return node;
+        case VAL_STRING:
+            node = create_ast_node(arena, AST_LITERAL_STRING, at->line, at->column);
+            node->data.string_literal.value = arena_strndup(arena, val.data.string_val->chars,
+                                                             val.data.string_val->length);
+            node->data.string_literal.length = val.data.string_val->length;
+            return node;
+        default:
+            return NULL;
+    }
+}
+
+// ==================== FOLDING ====================
+
+// Evaluate op on two constants exactly as the runtime would.
+// Returns 0 when the runtime would report an error or produce no result.
+static int fold_values(TokenType op, Value left, Value right, Value *result) {
+    if (op >= TOKEN_EQ && op <= TOKEN_LE) {
+        int holds = compare_values((CompareOp)(op - TOKEN_EQ), left, right);
+        if (holds < 0) return 0;
+        *result = bool_value(holds);
+        return 1;
+    }
+    
+    if (left.type == VAL_INT && right.type == VAL_INT) {
+        // Wrap like the runtime's int arithmetic, without signed overflow here
+        unsigned l = (unsigned)left.data.int_val;
+        unsigned r = (unsigned)right.data.int_val;
+        int a = left.data.int_val;
+        int b = right.data.int_val;
+        switch (op) {
+            case TOKEN_ADD: *result = int_value((int)(l + r)); return 1;
+            case TOKEN_SUB: *result = int_value((int)(l - r)); return 1;
+            case TOKEN_MUL: *result = int_value((int)(l * r)); return 1;
+            case TOKEN_DIV:
+                if (b == 0 || (a == INT_MIN && b == -1)) return 0;
+                *result = int_value(a / b);
+                return 1;
+            case TOKEN_MOD:
+                if (b == 0 || (a == INT_MIN && b == -1)) return 0;
+                *result = int_value(a % b);
+                return 1;
+            default: return 0;
+        }
+    }
+    
+    if ((left.type == VAL_FLOAT || right.type == VAL_FLOAT) &&
+        (left.type == VAL_INT || left.type == VAL_FLOAT) &&
+        (right.type == VAL_INT || right.type == VAL_FLOAT)) {
+        double l = left.type == VAL_FLOAT ? left.data.float_val : left.data.int_val;
+        double r = right.type == VAL_FLOAT ? right.data.float_val : right.data.int_val;
+        switch (op) {
+            case TOKEN_ADD: *result = float_value(l + r); return 1;
+            case TOKEN_SUB: *result = float_value(l - r); return 1;
+            case TOKEN_MUL: *result = float_value(l * r); return 1;
+            case TOKEN_DIV:
+                if (r == 0.0) return 0;
+                *result = float_value(l / r);
+                return 1;
+            default: return 0;
+        }
+    }
+    
+    if ((op == TOKEN_AND || op == TOKEN_OR) && left.type == VAL_BOOL && right.type == VAL_BOOL) {
+        *result = bool_value(op == TOKEN_AND ? left.data.bool_val && right.data.bool_val
+                                             : left.data.bool_val || right.data.bool_val);
+        return 1;
+    }
+    
+    return 0;
+}
+
+// Fold a literal-only operation; returns the replacement literal or NULL
+static ASTNode *fold_operation(Arena *arena, ASTNode *node) {
+    Value result;
+    int ok = 0;
+    
+    if (node->type == AST_BINARY_OP) {
+        if (!is_literal(node->data.binary_op.left) || !is_literal(node->data.binary_op.right)) {
+            return NULL;
+        }
+        Value left = literal_value(node->data.binary_op.left);
+        Value right = literal_value(node->data.binary_op.right);
+        ok = fold_values(node->data.binary_op.op, left, right, &result);
+        release_value(left);
+        release_value(right);
+    } else {
+        if (!is_literal(node->data.type_cast.value)) {
+            return NULL;
+        }
+        Value val = literal_value(node->data.type_cast.value);
+        ok = cast_value(val, cast_target(node->data.type_cast.target_type), &result);
+        release_value(val);
+    }
+    
+    if (!ok) return NULL;
+    ASTNode *literal = make_literal(arena, node, result);
+    release_value(result);
+    return literal;
+}
+
+static VarRef *result_of(ASTNode *node) {
+    return node->type == AST_BINARY_OP ? &node->data.binary_op.result
+                                       : &node->data.type_cast.result_var;
+}
+
+static ASTNode *fold_expression(Arena *arena, ASTNode *node);
+
+static void fold_all(Arena *arena, ASTNode **nodes, int count) {
+    for (int i = 0; i < count; i++) {
+        nodes[i] = fold_expression(arena, nodes[i]);
+    }
+}
+
+// Fold constants inside an expression. Operations that also store into
+// a result variable are only folded at statement level (see optimize_statement).
+static ASTNode *fold_expression(Arena *arena, ASTNode *node) {
+    if (!node) return NULL;
+    
+    switch (node->type) {
+        case AST_BINARY_OP:
+            node->data.binary_op.left = fold_expression(arena, node->data.binary_op.left);
+            node->data.binary_op.right = fold_expression(arena, node->data.binary_op.right);
+            break;
+        
+        case AST_TYPE_CAST:
+            node->data.type_cast.value = fold_expression(arena, node->data.type_cast.value);
+            break;
+        
+        case AST_ARRAY:
+            fold_all(arena, node->data.array.elements, node->data.array.element_count);
+            return node;
+        
+        case AST_ARRAY_ACCESS:
+            node->data.array_access.index = fold_expression(arena, node->data.array_access.index);
+            return node;
+        
+        default:
+            return node;
+    }
+    
+    if (result_of(node)->symbol != NO_SYMBOL) return node;
+    ASTNode *literal = fold_operation(arena, node);
+    return literal ? literal : node;
+}
+
+// ==================== STATEMENTS ====================
+
+// Does a statement (or anything nested in it) define a jump target?
+static int contains_label(ASTNode *node) {
+    if (!node) return 0;
+    
+    switch (node->type) {
+        case AST_LABEL:
+            return 1;
+        
+        case AST_IF_STATEMENT:
+            for (int i = 0; i < node->data.if_stmt.then_count; i++) {
+                if (contains_label(node->data.if_stmt.then_body[i])) return 1;
+            }
+            for (int i = 0; i < node->data.if_stmt.else_count; i++) {
+                if (contains_label(node->data.if_stmt.else_body[i])) return 1;
+            }
+            return 0;
+        
+        case AST_FOR_LOOP:
+            for (int i = 0; i < node->data.for_loop.body_count; i++) {
+                if (contains_label(node->data.for_loop.body[i])) return 1;
+            }
+            return 0;
+        
+        case AST_WHILE_LOOP:
+            for (int i = 0; i < node->data.while_loop.body_count; i++) {
+                if (contains_label(node->data.while_loop.body[i])) return 1;
+            }
+            return 0;
+        
+        default:
+            return 0;
+    }
+}
+
+// Control never falls through these
+static int ends_flow(ASTNode *node) {
+    return node->type == AST_HALT || node->type == AST_RETURN ||
+           (node->type == AST_JUMP && node->data.jump.jump_type == TOKEN_JMP);
+}
+
+// Truth value of a folded condition: 1, 0, or -1 when not constant
+static int constant_truth(ASTNode *node) {
+    switch (node->type) {
+        case AST_LITERAL_BOOL: return node->data.bool_literal.value != 0;
+        case AST_LITERAL_INT: return node->data.int_literal.value != 0;
+        case AST_LITERAL_FLOAT:
+        case AST_LITERAL_STRING: return 0;     // only bools and ints are truthy
+        default: return -1;
+    }
+}
+
+static ASTNode **optimize_block(Arena *arena, ASTNode **body, int count, int *new_count);
+
+static void optimize_statement(Arena *arena, ASTNode *node, NodeList *out) {
+    switch (node->type) {
+        case AST_BINARY_OP:
+        case AST_TYPE_CAST: {
+            ASTNode *folded = fold_expression(arena, node);
+            VarRef *result = result_of(node);
+            if (folded == node && result->symbol != NO_SYMBOL) {
+                // add 3,4 eq x  ->  set x,7
+                ASTNode *literal = fold_operation(arena, node);
+                if (literal) {
+                    ASTNode *assign = create_ast_node(arena, AST_ASSIGNMENT, node->line, node->column);
+                    assign->data.assignment.variable = *result;
+                    assign->data.assignment.value = literal;
+                    folded = assign;
+                }
+            }
+            // A bare literal left over has no effect
+            if (!is_literal(folded)) node_list_push(out, folded);
+            return;
+        }
+        
+        case AST_ASSIGNMENT:
+            node->data.assignment.value = fold_expression(arena, node->data.assignment.value);
+            break;
+        
+        case AST_UNARY_OP:
+            node->data.unary_op.amount = fold_expression(arena, node->data.unary_op.amount);
+            break;
+        
+        case AST_ECHO:
+            fold_all(arena, node->data.echo.expressions, node->data.echo.expr_count);
+            break;
+        
+        case AST_IF_STATEMENT: {
+            node->data.if_stmt.condition = fold_expression(arena, node->data.if_stmt.condition);
+            node->data.if_stmt.then_body = optimize_block(arena, node->data.if_stmt.then_body,
+                                                          node->data.if_stmt.then_count,
+                                                          &node->data.if_stmt.then_count);
+            node->data.if_stmt.else_body = optimize_block(arena, node->data.if_stmt.else_body,
+                                                          node->data.if_stmt.else_count,
+                                                          &node->data.if_stmt.else_count);
+            
+            // Constant condition: keep only the branch that runs, unless
+            // either one holds a label. Flattening the live branch would
+            // move its label out of the block and make a jump into it
+            // legal only at -O1
+            int truth = constant_truth(node->data.if_stmt.condition);
+            if (truth < 0) break;
+            if (contains_label(node)) break;
+            
+            ASTNode **live = truth ? node->data.if_stmt.then_body : node->data.if_stmt.else_body;
+            int live_count = truth ? node->data.if_stmt.then_count : node->data.if_stmt.else_count;
+            for (int i = 0; i < live_count; i++) {
+                node_list_push(out, live[i]);
+            }
+            return;
+        }
+        
+        case AST_FOR_LOOP:
+            node->data.for_loop.start = fold_expression(arena, node->data.for_loop.start);
+            node->data.for_loop.end = fold_expression(arena, node->data.for_loop.end);
+            node->data.for_loop.step = fold_expression(arena, node->data.for_loop.step);
+            node->data.for_loop.body = optimize_block(arena, node->data.for_loop.body,
+                                                      node->data.for_loop.body_count,
+                                                      &node->data.for_loop.body_count);
+            break;
+        
+        case AST_WHILE_LOOP:
+            node->data.while_loop.condition = fold_expression(arena, node->data.while_loop.condition);
+            node->data.while_loop.body = optimize_block(arena, node->data.while_loop.body,
+                                                        node->data.while_loop.body_count,
+                                                        &node->data.while_loop.body_count);
+            break;
+        
+        case AST_FUNCTION_CALL:
+            fold_all(arena, node->data.function_call.arguments, node->data.function_call.arg_count);
+            break;
+        
+        case AST_RETURN:
+            fold_all(arena, node->data.return_stmt.values, node->data.return_stmt.value_count);
+            break;
+        
+        case AST_JUMP:
+            node->data.jump.left = fold_expression(arena, node->data.jump.left);
+            node->data.jump.right = fold_expression(arena, node->data.jump.right);
+            break;
+        
+        case AST_FUNCTION:
+            node->data.function.body = optimize_block(arena, node->data.function.body,
+                                                      node->data.function.body_count,
+                                                      &node->data.function.body_count);
+            break;
+        
+        default:
+            break;
+    }
+    
+    node_list_push(out, node);
+}
+
+// Optimise a statement list, dropping whatever follows a halt, a ret or
+// an unconditional jmp up to the next label
+static ASTNode **optimize_block(Arena *arena, ASTNode **body, int count, int *new_count) {
+    NodeList out = {0};
+    int reachable = 1;
+    
+    for (int i = 0; i < count; i++) {
+        ASTNode *stmt = body[i];
+        
+        // Function definitions sit between .main statements but are not
+        // part of its control flow
+        if (stmt->type != AST_FUNCTION) {
+            if (!reachable && !contains_label(stmt)) continue;
+            reachable = 1;
+        }
+        
+        int before = out.count;
+        optimize_statement(arena, stmt, &out);
+        for (int j = before; j < out.count; j++) {
+            if (ends_flow(out.items[j])) reachable = 0;
+        }
+    }
+    
+    *new_count = out.count;
+    ASTNode **result = NULL;
+    if (out.count > 0) {
+        result = arena_alloc(arena, sizeof(ASTNode*) * out.count);
+        memcpy(result, out.items, sizeof(ASTNode*) * out.count);
+    }
+    free(out.items);
+    return result;
+}
+
+void optimize(ASTNode *program, Arena *arena, int level) {
+    if (level < OPT_FOLD) return;
+    
+    program->data.program.statements = optimize_block(arena, program->data.program.statements,
+                                                      program->data.program.statement_count,
+                                                      &program->data.program.statement_count);
+}
@@ -0,0 +1,14 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "ast.h"
+
+// AST optimisation levels (ratio -O<level>)
+#define OPT_NONE 0
+#define OPT_FOLD 1           // constant folding, dead branches, unreachable code
+
+// Rewrite the program in place; new nodes come from the parse arena.
+// Runs before resolve().
+void optimize(ASTNode *program, Arena *arena, int level);
+
+#endif
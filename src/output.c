@@ -0,0 +1,127 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "output.h"
+#include "number.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define OUTPUT_BUFFER_SIZE (256 * 1024)
+
+static struct {
+    char data[OUTPUT_BUFFER_SIZE];
+    size_t length;
+    int unbuffered;
+} output;
+
+void output_set_unbuffered(int unbuffered) {
+    output.unbuffered = unbuffered;
+}
+
+static void write_all(const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(STDOUT_FILENO, data, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;     // nowhere left to report it; drop the output
+        }
+        data += n;
+        length -= n;
+    }
+}
+
+void output_flush(void) {
+    // Anything printed through stdio (banners, debug dumps) comes first
+    fflush(stdout);
+    write_all(output.data, output.length);
+    output.length = 0;
+}
+
+void runtime_error(const char *format, ...) {
+    output_flush();
+    
+    va_list args;
+    va_start(args, format);
+    fputs("Runtime Error: ", stderr);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+void output_bytes(const char *data, size_t length) {
+    if (output.length + length > OUTPUT_BUFFER_SIZE) {
+        output_flush();
+        if (length > OUTPUT_BUFFER_SIZE) {
+            write_all(data, length);
+            return;
+        }
+    }
+    memcpy(output.data + output.length, data, length);
+    output.length += length;
+    
+    // A string can finish a line too
+    if (output.unbuffered && memchr(data, '\n', length)) {
+        output_flush();
+    }
+}
+
+void output_char(char c) {
+    if (output.length == OUTPUT_BUFFER_SIZE) {
+        output_flush();
+    }
+    output.data[output.length++] = c;
+    if (c == '\n' && output.unbuffered) {
+        output_flush();
+    }
+}
+
+void output_int(int value) {
+    char digits[12];
+    char *p = digits + sizeof(digits);
+    unsigned magnitude = value < 0 ? 0u - (unsigned)value : (unsigned)value;
+    do {
+        *--p = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        *--p = '-';
+    }
+    output_bytes(p, digits + sizeof(digits) - p);
+}
+
+void output_value(Value val) {
+    switch (val.type) {
+        case VAL_INT:
+            output_int(val.data.int_val);
+            break;
+        case VAL_FLOAT: {
+            char text[DOUBLE_TEXT_SIZE];
+            output_bytes(text, format_double(val.data.float_val, text));
+            break;
+        }
+        case VAL_STRING:
+            output_bytes(val.data.string_val->chars, val.data.string_val->length);
+            break;
+        case VAL_BOOL:
+            if (val.data.bool_val) {
+                output_bytes("true", 4);
+            } else {
+                output_bytes("false", 5);
+            }
+            break;
+        case VAL_ARRAY:
+            output_char('{');
+            for (int i = 0; i < val.data.array_val->count; i++) {
+                output_value(val.data.array_val->elements[i]);
+                if (i < val.data.array_val->count - 1) output_bytes(", ", 2);
+            }
+            output_char('}');
+            break;
+        case VAL_NULL:
+        case VAL_UNDEFINED:
+            output_bytes("null", 4);
+            break;
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stddef.h>
+#include "value.h"
+
+// Program output (echo, halt). Text collects in one large buffer that goes
+// to stdout with a single write(2) when it fills up, when the program ends
+// or halts, at exit, and before a runtime error is reported. In unbuffered
+// mode every finished line is written straight away, for interactive use.
+
+void output_set_unbuffered(int unbuffered);
+
+void output_bytes(const char *data, size_t length);
+void output_char(char c);
+void output_int(int value);
+void output_value(Value val);        // same text as print_value()
+
+// Write out everything buffered so far (stdio's own buffer goes first)
+void output_flush(void);
+
+// "Runtime Error: <message>" on stderr, after the output that preceded it
+void runtime_error(const char *format, ...);
+
+#endif
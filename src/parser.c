@@ -5,12 +5,23 @@
 #include <stdlib.h>
 #include <string.h>
 
-// Create parser
-Parser *create_parser(Token **tokens, int token_count) {
+// Create parser over a pre-tokenized array
+Parser *create_parser(Token *tokens, int token_count, Arena *arena) {
     Parser *parser = malloc(sizeof(Parser));
+    parser->arena = arena;
+    parser->lexer = NULL;
     parser->tokens = tokens;
     parser->token_count = token_count;
-    parser->current = 0;
+    parser->next_index = 0;
+    parser->head = 0;
+    parser->buffered = 0;
+    return parser;
+}
+
+// Create parser that pulls tokens from the lexer on demand
+Parser *create_streaming_parser(Lexer *lexer, Arena *arena) {
+    Parser *parser = create_parser(NULL, 0, arena);
+    parser->lexer = lexer;
     return parser;
 }
 
@@ -21,27 +32,37 @@ void free_parser(Parser *parser) {
     }
 }
 
-// Get current token
-Token *current_token(Parser *parser) {
-    if (parser->current < parser->token_count) {
-        return parser->tokens[parser->current];
+// Produce the next token from whichever source backs the parser
+static Token fetch_token(Parser *parser) {
+    if (parser->lexer) {
+        return get_next_token(parser->lexer);
+    }
+    if (parser->next_index < parser->token_count - 1) {
+        return parser->tokens[parser->next_index++];
     }
     return parser->tokens[parser->token_count - 1]; // EOF
 }
 
-// Peek ahead
+// Peek ahead (offset must be below PARSER_LOOKAHEAD)
 Token *peek_token(Parser *parser, int offset) {
-    int pos = parser->current + offset;
-    if (pos < parser->token_count) {
-        return parser->tokens[pos];
+    while (parser->buffered <= offset) {
+        int slot = (parser->head + parser->buffered) & (PARSER_LOOKAHEAD - 1);
+        parser->ring[slot] = fetch_token(parser);
+        parser->buffered++;
     }
-    return parser->tokens[parser->token_count - 1]; // EOF
+    return &parser->ring[(parser->head + offset) & (PARSER_LOOKAHEAD - 1)];
+}
+
+// Get current token
+Token *current_token(Parser *parser) {
+    return peek_token(parser, 0);
 }
 
-// Move to next token
+// Move to next token (EOF is sticky)
 void advance_parser(Parser *parser) {
-    if (parser->current < parser->token_count - 1) {
-        parser->current++;
+    if (current_token(parser)->type != TOKEN_EOF) {
+        parser->head = (parser->head + 1) & (PARSER_LOOKAHEAD - 1);
+        parser->buffered--;
     }
 }
 
@@ -61,22 +82,22 @@ int match_any(Parser *parser, TokenType *types, int count) {
 }
 
 // Consume token of expected type
-Token *consume(Parser *parser, TokenType type, const char *error_message) {
-    Token *token = current_token(parser);
-    if (token->type != type) {
+Token consume(Parser *parser, TokenType type, const char *error_message) {
+    Token token = *current_token(parser);
+    if (token.type != type) {
         fprintf(stderr, "Parse Error [%d:%d]: %s (got %s)\n",
-                token->line, token->column,
+                token.line, token.column,
                 error_message,
-                token_type_name(token->type));
+                token_type_name(token.type));
         exit(1);
     }
     advance_parser(parser);
     return token;
 }
 
-// Create AST node
-ASTNode *create_ast_node(ASTNodeType type, int line, int column) {
-    ASTNode *node = malloc(sizeof(ASTNode));
+// Create AST node (owned by the arena)
+ASTNode *create_ast_node(Arena *arena, ASTNodeType type, int line, int column) {
+    ASTNode *node = arena_alloc(arena, sizeof(ASTNode));
     memset(node, 0, sizeof(ASTNode));
     node->type = type;
     node->line = line;
@@ -84,8 +105,82 @@ ASTNode *create_ast_node(ASTNodeType type, int line, int column) {
     return node;
 }
 
+// Copy a string literal into the AST arena, resolving \" escapes
+static char *unescape_string(Parser *parser, const Token *token, int *length) {
+    char *text = arena_alloc(parser->arena, token->length + 1);
+    int j = 0;
+    for (int i = 0; i < token->length; i++) {
+        if (token->start[i] == '\\' && i + 1 < token->length && token->start[i + 1] == '"') {
+            i++;
+        }
+        text[j++] = token->start[i];
+    }
+    text[j] = '\0';
+    *length = j;
+    return text;
+}
+
+// ==================== GROWABLE LISTS ====================
+
+// Child list under construction: grows geometrically in scratch memory,
+// then is copied into the arena at its exact size once the block closes.
+typedef struct {
+    void **items;
+    int count;
+    int capacity;
+} PtrList;
+
+static void list_push(PtrList *list, void *item) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 8;
+        list->items = realloc(list->items, sizeof(void*) * list->capacity);
+    }
+    list->items[list->count++] = item;
+}
+
+// Move the list into the arena (NULL when empty) and release the scratch buffer
+static void *list_finish(Parser *parser, PtrList *list) {
+    void **items = NULL;
+    if (list->count > 0) {
+        items = arena_alloc(parser->arena, sizeof(void*) * list->count);
+        memcpy(items, list->items, sizeof(void*) * list->count);
+    }
+    free(list->items);
+    list->items = NULL;
+    list->capacity = 0;
+    return items;
+}
+
+// Symbol list (parameters, result variables), same growth scheme
+typedef struct {
+    int *items;
+    int count;
+    int capacity;
+} IntList;
+
+static void int_list_push(IntList *list, int item) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 8;
+        list->items = realloc(list->items, sizeof(int) * list->capacity);
+    }
+    list->items[list->count++] = item;
+}
+
+static int *int_list_finish(Parser *parser, IntList *list) {
+    int *items = NULL;
+    if (list->count > 0) {
+        items = arena_alloc(parser->arena, sizeof(int) * list->count);
+        memcpy(items, list->items, sizeof(int) * list->count);
+    }
+    free(list->items);
+    list->items = NULL;
+    list->capacity = 0;
+    return items;
+}
+
 // Forward declarations for parsing functions
 static ASTNode *parse_statement(Parser *parser);
+static ASTNode **parse_block(Parser *parser, TokenType *terminators, int terminator_count, int *count);
 static ASTNode *parse_expression(Parser *parser);
 static ASTNode *parse_primary(Parser *parser);
 
@@ -93,42 +188,47 @@ static ASTNode *parse_primary(Parser *parser);
 
 // Parse primary expression (literals, identifiers, arrays, etc.)
 static ASTNode *parse_primary(Parser *parser) {
-    Token *token = current_token(parser);
+    Token token = *current_token(parser);
     
     // Integer literal
     if (match(parser, TOKEN_INT)) {
-        ASTNode *node = create_ast_node(AST_LITERAL_INT, token->line, token->column);
-        node->data.int_literal.value = atoi(token->value);
+        ASTNode *node = create_ast_node(parser->arena, AST_LITERAL_INT, token.line, token.column);
+        if (!token_int_value(&token, &node->data.int_literal.value)) {
+            fprintf(stderr, "Parse Error [%d:%d]: Integer literal %.*s is out of range\n",
+                    token.line, token.column, token.length, token.start);
+            exit(1);
+        }
         advance_parser(parser);
         return node;
     }
     
     // Float literal
     if (match(parser, TOKEN_FLOAT)) {
-        ASTNode *node = create_ast_node(AST_LITERAL_FLOAT, token->line, token->column);
-        node->data.float_literal.value = atof(token->value);
+        ASTNode *node = create_ast_node(parser->arena, AST_LITERAL_FLOAT, token.line, token.column);
+        node->data.float_literal.value = token_float_value(&token);
         advance_parser(parser);
         return node;
     }
     
     // String literal
     if (match(parser, TOKEN_STRING)) {
-        ASTNode *node = create_ast_node(AST_LITERAL_STRING, token->line, token->column);
-        node->data.string_literal.value = strdup(token->value);
+        ASTNode *node = create_ast_node(parser->arena, AST_LITERAL_STRING, token.line, token.column);
+        node->data.string_literal.value = unescape_string(parser, &token,
+                                                           &node->data.string_literal.length);
         advance_parser(parser);
         return node;
     }
     
     // Boolean literals
     if (match(parser, TOKEN_BOOL_TRUE)) {
-        ASTNode *node = create_ast_node(AST_LITERAL_BOOL, token->line, token->column);
+        ASTNode *node = create_ast_node(parser->arena, AST_LITERAL_BOOL, token.line, token.column);
         node->data.bool_literal.value = 1;
         advance_parser(parser);
         return node;
     }
     
     if (match(parser, TOKEN_BOOL_FALSE)) {
-        ASTNode *node = create_ast_node(AST_LITERAL_BOOL, token->line, token->column);
+        ASTNode *node = create_ast_node(parser->arena, AST_LITERAL_BOOL, token.line, token.column);
         node->data.bool_literal.value = 0;
         advance_parser(parser);
         return node;
@@ -136,7 +236,7 @@ static ASTNode *parse_primary(Parser *parser) {
     
     // Input: $
     if (match(parser, TOKEN_DOLLAR)) {
-        ASTNode *node = create_ast_node(AST_INPUT, token->line, token->column);
+        ASTNode *node = create_ast_node(parser->arena, AST_INPUT, token.line, token.column);
         advance_parser(parser);
         
         // Optional prompt string
@@ -150,15 +250,14 @@ static ASTNode *parse_primary(Parser *parser) {
     
     // Array literal: {1,2,3}
     if (match(parser, TOKEN_LBRACE)) {
-        ASTNode *node = create_ast_node(AST_ARRAY, token->line, token->column);
+        ASTNode *node = create_ast_node(parser->arena, AST_ARRAY, token.line, token.column);
         advance_parser(parser); // skip {
         
         // Parse array elements
-        ASTNode **elements = malloc(sizeof(ASTNode*) * 100);
-        int count = 0;
+        PtrList elements = {0};
         
         while (!match(parser, TOKEN_RBRACE) && !match(parser, TOKEN_EOF)) {
-            elements[count++] = parse_expression(parser);
+            list_push(&elements, parse_expression(parser));
             if (match(parser, TOKEN_COMMA)) {
                 advance_parser(parser);
             }
@@ -166,21 +265,21 @@ static ASTNode *parse_primary(Parser *parser) {
         
         consume(parser, TOKEN_RBRACE, "Expected '}' after array elements");
         
-        node->data.array.elements = elements;
-        node->data.array.element_count = count;
+        node->data.array.element_count = elements.count;
+        node->data.array.elements = list_finish(parser, &elements);
         return node;
     }
     
     // Identifier (variable or function call or array access)
     if (match(parser, TOKEN_IDENTIFIER)) {
-        char *name = strdup(token->value);
+        int name = token.symbol;
         advance_parser(parser);
         
         // Array access: arr[0]
         if (match(parser, TOKEN_LBRACKET)) {
-            ASTNode *node = create_ast_node(AST_ARRAY_ACCESS, token->line, token->column);
+            ASTNode *node = create_ast_node(parser->arena, AST_ARRAY_ACCESS, token.line, token.column);
             advance_parser(parser); // skip [
-            node->data.array_access.array_name = name;
+            node->data.array_access.array_name.symbol = name;
             node->data.array_access.index = parse_expression(parser);
             consume(parser, TOKEN_RBRACKET, "Expected ']' after array index");
             return node;
@@ -189,16 +288,16 @@ static ASTNode *parse_primary(Parser *parser) {
         // Property access: arr.len
         if (match(parser, TOKEN_DOT)) {
             advance_parser(parser); // skip .
-            Token *prop = consume(parser, TOKEN_IDENTIFIER, "Expected property name after '.'");
-            ASTNode *node = create_ast_node(AST_PROPERTY_ACCESS, token->line, token->column);
-            node->data.property_access.object_name = name;
-            node->data.property_access.property = strdup(prop->value);
+            Token prop = consume(parser, TOKEN_IDENTIFIER, "Expected property name after '.'");
+            ASTNode *node = create_ast_node(parser->arena, AST_PROPERTY_ACCESS, token.line, token.column);
+            node->data.property_access.object_name.symbol = name;
+            node->data.property_access.property = prop.symbol;
             return node;
         }
         
         // Just an identifier
-        ASTNode *node = create_ast_node(AST_IDENTIFIER, token->line, token->column);
-        node->data.identifier.name = name;
+        ASTNode *node = create_ast_node(parser->arena, AST_IDENTIFIER, token.line, token.column);
+        node->data.identifier.name.symbol = name;
         return node;
     }
     
@@ -211,61 +310,62 @@ static ASTNode *parse_primary(Parser *parser) {
     }
     
     fprintf(stderr, "Parse Error [%d:%d]: Unexpected token %s\n",
-            token->line, token->column, token_type_name(token->type));
+            token.line, token.column, token_type_name(token.type));
     exit(1);
 }
 
 // Parse expression (operations, comparisons, etc.)
 static ASTNode *parse_expression(Parser *parser) {
-    Token *token = current_token(parser);
+    Token token = *current_token(parser);
     
     // Type cast: int x, float y, str z, bool b
     if (match(parser, TOKEN_INT_CAST) || match(parser, TOKEN_FLOAT_CAST) ||
         match(parser, TOKEN_STR_CAST) || match(parser, TOKEN_BOOL_CAST)) {
-        TokenType cast_type = token->type;
+        TokenType cast_type = token.type;
         advance_parser(parser);
         
-        ASTNode *value = parse_expression(parser);
+        ASTNode *value = parse_primary(parser);
         
         // Check for result: int x eq y
-        char *result_var = NULL;
+        int result_var = NO_SYMBOL;
         if (match(parser, TOKEN_EQ)) {
             advance_parser(parser);
-            Token *var = consume(parser, TOKEN_IDENTIFIER, "Expected variable name after 'eq'");
-            result_var = strdup(var->value);
+            Token var = consume(parser, TOKEN_IDENTIFIER, "Expected variable name after 'eq'");
+            result_var = var.symbol;
         }
         
-        ASTNode *node = create_ast_node(AST_TYPE_CAST, token->line, token->column);
+        ASTNode *node = create_ast_node(parser->arena, AST_TYPE_CAST, token.line, token.column);
         node->data.type_cast.target_type = cast_type;
         node->data.type_cast.value = value;
-        node->data.type_cast.result_var = result_var;
+        node->data.type_cast.result_var.symbol = result_var;
         return node;
     }
     
-    // Binary operations: add, sub, mul, div, mod
+    // Binary operations: add, sub, mul, div, mod, concat
     if (match(parser, TOKEN_ADD) || match(parser, TOKEN_SUB) || 
         match(parser, TOKEN_MUL) || match(parser, TOKEN_DIV) || 
-        match(parser, TOKEN_MOD)) {
-        TokenType op = token->type;
+        match(parser, TOKEN_MOD) || match(parser, TOKEN_CONCAT)) {
+        TokenType op = token.type;
         advance_parser(parser);
         
-        ASTNode *left = parse_expression(parser);
+        // Operands are single values so a trailing 'eq' names the result
+        ASTNode *left = parse_primary(parser);
         consume(parser, TOKEN_COMMA, "Expected ',' after first operand");
-        ASTNode *right = parse_expression(parser);
+        ASTNode *right = parse_primary(parser);
         
         // Optional result: add x,y eq z
-        char *result = NULL;
+        int result = NO_SYMBOL;
         if (match(parser, TOKEN_EQ)) {
             advance_parser(parser);
-            Token *res = consume(parser, TOKEN_IDENTIFIER, "Expected variable name after 'eq'");
-            result = strdup(res->value);
+            Token res = consume(parser, TOKEN_IDENTIFIER, "Expected variable name after 'eq'");
+            result = res.symbol;
         }
         
-        ASTNode *node = create_ast_node(AST_BINARY_OP, token->line, token->column);
+        ASTNode *node = create_ast_node(parser->arena, AST_BINARY_OP, token.line, token.column);
         node->data.binary_op.op = op;
         node->data.binary_op.left = left;
         node->data.binary_op.right = right;
-        node->data.binary_op.result = result;
+        node->data.binary_op.result.symbol = result;
         return node;
     }
     
@@ -283,11 +383,11 @@ static ASTNode *parse_expression(Parser *parser) {
         
         ASTNode *right = parse_expression(parser);
         
-        ASTNode *node = create_ast_node(AST_BINARY_OP, line, col);
+        ASTNode *node = create_ast_node(parser->arena, AST_BINARY_OP, line, col);
         node->data.binary_op.op = op;
         node->data.binary_op.left = left;
         node->data.binary_op.right = right;
-        node->data.binary_op.result = NULL;
+        node->data.binary_op.result.symbol = NO_SYMBOL;
         return node;
     }
     
@@ -300,11 +400,11 @@ static ASTNode *parse_expression(Parser *parser) {
         
         ASTNode *right = parse_expression(parser);
         
-        ASTNode *node = create_ast_node(AST_BINARY_OP, line, col);
+        ASTNode *node = create_ast_node(parser->arena, AST_BINARY_OP, line, col);
         node->data.binary_op.op = op;
         node->data.binary_op.left = left;
         node->data.binary_op.right = right;
-        node->data.binary_op.result = NULL;
+        node->data.binary_op.result.symbol = NO_SYMBOL;
         return node;
     }
     
@@ -315,10 +415,10 @@ static ASTNode *parse_expression(Parser *parser) {
 
 // Parse assignment: set x,10 or set x eq 10
 static ASTNode *parse_assignment(Parser *parser) {
-    Token *token = current_token(parser);
+    Token token = *current_token(parser);
     advance_parser(parser); // skip 'set'
     
-    Token *var = consume(parser, TOKEN_IDENTIFIER, "Expected variable name after 'set'");
+    Token var = consume(parser, TOKEN_IDENTIFIER, "Expected variable name after 'set'");
     
     // Expect comma or 'eq'
     if (!match(parser, TOKEN_COMMA) && !match(parser, TOKEN_EQ)) {
@@ -329,34 +429,33 @@ static ASTNode *parse_assignment(Parser *parser) {
     
     ASTNode *value = parse_expression(parser);
     
-    ASTNode *node = create_ast_node(AST_ASSIGNMENT, token->line, token->column);
-    node->data.assignment.variable = strdup(var->value);
+    ASTNode *node = create_ast_node(parser->arena, AST_ASSIGNMENT, token.line, token.column);
+    node->data.assignment.variable.symbol = var.symbol;
     node->data.assignment.value = value;
     return node;
 }
 
 // Parse echo: echo "text" var "more"
 static ASTNode *parse_echo(Parser *parser) {
-    Token *token = current_token(parser);
+    Token token = *current_token(parser);
     advance_parser(parser); // skip 'echo'
     
-    ASTNode *node = create_ast_node(AST_ECHO, token->line, token->column);
-    ASTNode **expressions = malloc(sizeof(ASTNode*) * 100);
-    int count = 0;
+    ASTNode *node = create_ast_node(parser->arena, AST_ECHO, token.line, token.column);
+    PtrList expressions = {0};
     
     // Parse all expressions until newline or EOF
     while (!match(parser, TOKEN_NEWLINE) && !match(parser, TOKEN_EOF)) {
-        expressions[count++] = parse_expression(parser);
+        list_push(&expressions, parse_expression(parser));
     }
     
-    node->data.echo.expressions = expressions;
-    node->data.echo.expr_count = count;
+    node->data.echo.expr_count = expressions.count;
+    node->data.echo.expressions = list_finish(parser, &expressions);
     return node;
 }
 
 // Parse if statement
 static ASTNode *parse_if(Parser *parser) {
-    Token *token = current_token(parser);
+    Token token = *current_token(parser);
     advance_parser(parser); // skip 'if'
     
     // Optional parentheses
@@ -372,53 +471,29 @@ static ASTNode *parse_if(Parser *parser) {
         consume(parser, TOKEN_RPAREN, "Expected ')' after condition");
     }
     
-    // Skip newlines after condition
-    while (match(parser, TOKEN_NEWLINE)) {
-        advance_parser(parser);
-    }
-    
     // Parse then body
-    ASTNode **then_body = malloc(sizeof(ASTNode*) * 100);
+    TokenType then_end[] = {TOKEN_ELSEIF, TOKEN_ELSE, TOKEN_ENDB};
     int then_count = 0;
-    
-    while (!match(parser, TOKEN_ELSEIF) && !match(parser, TOKEN_ELSE) && 
-           !match(parser, TOKEN_ENDB) && !match(parser, TOKEN_EOF)) {
-        then_body[then_count++] = parse_statement(parser);
-        
-        // Skip newlines after each statement
-        while (match(parser, TOKEN_NEWLINE)) {
-            advance_parser(parser);
-        }
-    }
+    ASTNode **then_body = parse_block(parser, then_end, 3, &then_count);
     
     // Parse else/elseif
-    ASTNode **else_body = malloc(sizeof(ASTNode*) * 100);
+    ASTNode **else_body = NULL;
     int else_count = 0;
     
     if (match(parser, TOKEN_ELSEIF)) {
         // TODO: Handle elseif as nested if
+        else_body = arena_alloc(parser->arena, sizeof(ASTNode*));
         else_body[else_count++] = parse_if(parser);
     } else if (match(parser, TOKEN_ELSE)) {
         advance_parser(parser);
         
-        // Skip newlines after else
-        while (match(parser, TOKEN_NEWLINE)) {
-            advance_parser(parser);
-        }
-        
-        while (!match(parser, TOKEN_ENDB) && !match(parser, TOKEN_EOF)) {
-            else_body[else_count++] = parse_statement(parser);
-            
-            // Skip newlines after each statement
-            while (match(parser, TOKEN_NEWLINE)) {
-                advance_parser(parser);
-            }
-        }
+        TokenType else_end[] = {TOKEN_ENDB};
+        else_body = parse_block(parser, else_end, 1, &else_count);
     }
     
     consume(parser, TOKEN_ENDB, "Expected 'endb' to close if statement");
     
-    ASTNode *node = create_ast_node(AST_IF_STATEMENT, token->line, token->column);
+    ASTNode *node = create_ast_node(parser->arena, AST_IF_STATEMENT, token.line, token.column);
     node->data.if_stmt.condition = condition;
     node->data.if_stmt.then_body = then_body;
     node->data.if_stmt.then_count = then_count;
@@ -429,10 +504,10 @@ static ASTNode *parse_if(Parser *parser) {
 
 // Parse for loop
 static ASTNode *parse_for(Parser *parser) {
-    Token *token = current_token(parser);
+    Token token = *current_token(parser);
     advance_parser(parser); // skip 'for'
     
-    Token *var = consume(parser, TOKEN_IDENTIFIER, "Expected loop variable");
+    Token var = consume(parser, TOKEN_IDENTIFIER, "Expected loop variable");
     consume(parser, TOKEN_LPAREN, "Expected '(' after loop variable");
     
     ASTNode *start = parse_expression(parser);
@@ -449,35 +524,22 @@ static ASTNode *parse_for(Parser *parser) {
     consume(parser, TOKEN_RPAREN, "Expected ')' after loop range");
     
     // Optional label: for i (1...10) _myloop
-    char *label = NULL;
+    int label = NO_SYMBOL;
     if (match(parser, TOKEN_UNDERSCORE)) {
         advance_parser(parser);
-        Token *label_token = consume(parser, TOKEN_IDENTIFIER, "Expected label name after '_'");
-        label = strdup(label_token->value);
-    }
-    
-    // Skip newlines after for declaration
-    while (match(parser, TOKEN_NEWLINE)) {
-        advance_parser(parser);
+        Token label_token = consume(parser, TOKEN_IDENTIFIER, "Expected label name after '_'");
+        label = label_token.symbol;
     }
     
     // Parse body
-    ASTNode **body = malloc(sizeof(ASTNode*) * 100);
+    TokenType body_end[] = {TOKEN_ENDL};
     int body_count = 0;
-    
-    while (!match(parser, TOKEN_ENDL) && !match(parser, TOKEN_EOF)) {
-        body[body_count++] = parse_statement(parser);
-        
-        // Skip newlines after each statement
-        while (match(parser, TOKEN_NEWLINE)) {
-            advance_parser(parser);
-        }
-    }
+    ASTNode **body = parse_block(parser, body_end, 1, &body_count);
     
     consume(parser, TOKEN_ENDL, "Expected 'endl' to close for loop");
     
-    ASTNode *node = create_ast_node(AST_FOR_LOOP, token->line, token->column);
-    node->data.for_loop.variable = strdup(var->value);
+    ASTNode *node = create_ast_node(parser->arena, AST_FOR_LOOP, token.line, token.column);
+    node->data.for_loop.variable.symbol = var.symbol;
     node->data.for_loop.start = start;
     node->data.for_loop.end = end;
     node->data.for_loop.step = step;
@@ -488,7 +550,7 @@ static ASTNode *parse_for(Parser *parser) {
 }
 // Parse while loop
 static ASTNode *parse_while(Parser *parser) {
-    Token *token = current_token(parser);
+    Token token = *current_token(parser);
     advance_parser(parser); // skip 'while'
     
     // Optional parentheses
@@ -505,24 +567,21 @@ static ASTNode *parse_while(Parser *parser) {
     }
     
     // Optional label
-    char *label = NULL;
+    int label = NO_SYMBOL;
     if (match(parser, TOKEN_UNDERSCORE)) {
         advance_parser(parser);
-        Token *label_token = consume(parser, TOKEN_IDENTIFIER, "Expected label name after '_'");
-        label = strdup(label_token->value);
+        Token label_token = consume(parser, TOKEN_IDENTIFIER, "Expected label name after '_'");
+        label = label_token.symbol;
     }
     
     // Parse body
-    ASTNode **body = malloc(sizeof(ASTNode*) * 100);
+    TokenType body_end[] = {TOKEN_ENDL};
     int body_count = 0;
-    
-    while (!match(parser, TOKEN_ENDL) && !match(parser, TOKEN_EOF)) {
-        body[body_count++] = parse_statement(parser);
-    }
+    ASTNode **body = parse_block(parser, body_end, 1, &body_count);
     
     consume(parser, TOKEN_ENDL, "Expected 'endl' to close while loop");
     
-    ASTNode *node = create_ast_node(AST_WHILE_LOOP, token->line, token->column);
+    ASTNode *node = create_ast_node(parser->arena, AST_WHILE_LOOP, token.line, token.column);
     node->data.while_loop.condition = condition;
     node->data.while_loop.body = body;
     node->data.while_loop.body_count = body_count;
@@ -532,29 +591,29 @@ static ASTNode *parse_while(Parser *parser) {
 
 // Parse break/continue
 static ASTNode *parse_break_continue(Parser *parser) {
-    Token *token = current_token(parser);
-    TokenType type = token->type;
+    Token token = *current_token(parser);
+    TokenType type = token.type;
     advance_parser(parser);
     
     // Optional label: break outer
-    char *label = NULL;
+    int label = NO_SYMBOL;
     if (match(parser, TOKEN_IDENTIFIER)) {
-        label = strdup(current_token(parser)->value);
+        label = current_token(parser)->symbol;
         advance_parser(parser);
     }
     
-    ASTNode *node = create_ast_node(type == TOKEN_BREAK ? AST_BREAK : AST_CONTINUE, 
-                                    token->line, token->column);
+    ASTNode *node = create_ast_node(parser->arena, type == TOKEN_BREAK ? AST_BREAK : AST_CONTINUE, 
+                                    token.line, token.column);
     node->data.break_continue.label = label;
     return node;
 }
 
 // Parse halt
 static ASTNode *parse_halt(Parser *parser) {
-    Token *token = current_token(parser);
+    Token token = *current_token(parser);
     advance_parser(parser); // skip 'halt'
     
-    ASTNode *node = create_ast_node(AST_HALT, token->line, token->column);
+    ASTNode *node = create_ast_node(parser->arena, AST_HALT, token.line, token.column);
     
     // Optional message
     if (match(parser, TOKEN_STRING)) {
@@ -568,11 +627,11 @@ static ASTNode *parse_halt(Parser *parser) {
 
 // Parse inc/dec
 static ASTNode *parse_inc_dec(Parser *parser) {
-    Token *token = current_token(parser);
-    TokenType op = token->type;
+    Token token = *current_token(parser);
+    TokenType op = token.type;
     advance_parser(parser);
     
-    Token *var = consume(parser, TOKEN_IDENTIFIER, "Expected variable name");
+    Token var = consume(parser, TOKEN_IDENTIFIER, "Expected variable name");
     
     // Optional amount: inc x,5
     ASTNode *amount = NULL;
@@ -581,27 +640,26 @@ static ASTNode *parse_inc_dec(Parser *parser) {
         amount = parse_expression(parser);
     }
     
-    ASTNode *node = create_ast_node(AST_UNARY_OP, token->line, token->column);
+    ASTNode *node = create_ast_node(parser->arena, AST_UNARY_OP, token.line, token.column);
     node->data.unary_op.op = op;
-    node->data.unary_op.variable = strdup(var->value);
+    node->data.unary_op.variable.symbol = var.symbol;
     node->data.unary_op.amount = amount;
     return node;
 }
 // Parse function call: call .func(a,b) eq result
 static ASTNode *parse_function_call(Parser *parser) {
-    Token *token = current_token(parser);
+    Token token = *current_token(parser);
     advance_parser(parser); // skip 'call'
     
-    Token *func_name = consume(parser, TOKEN_LABEL, "Expected function name after 'call'");
+    Token func_name = consume(parser, TOKEN_LABEL, "Expected function name after 'call'");
     
     // Parse arguments
     consume(parser, TOKEN_LPAREN, "Expected '(' after function name");
     
-    ASTNode **arguments = malloc(sizeof(ASTNode*) * 50);
-    int arg_count = 0;
+    PtrList arguments = {0};
     
     while (!match(parser, TOKEN_RPAREN) && !match(parser, TOKEN_EOF)) {
-        arguments[arg_count++] = parse_expression(parser);
+        list_push(&arguments, parse_expression(parser));
         if (match(parser, TOKEN_COMMA)) {
             advance_parser(parser);
         }
@@ -610,16 +668,14 @@ static ASTNode *parse_function_call(Parser *parser) {
     consume(parser, TOKEN_RPAREN, "Expected ')' after arguments");
     
     // Optional result variables: call .func() eq x,y,z
-    char **result_vars = NULL;
-    int result_count = 0;
+    IntList result_vars = {0};
     
     if (match(parser, TOKEN_EQ)) {
         advance_parser(parser);
-        result_vars = malloc(sizeof(char*) * 50);
         
         do {
-            Token *var = consume(parser, TOKEN_IDENTIFIER, "Expected variable name after 'eq'");
-            result_vars[result_count++] = strdup(var->value);
+            Token var = consume(parser, TOKEN_IDENTIFIER, "Expected variable name after 'eq'");
+            int_list_push(&result_vars, var.symbol);
             
             if (match(parser, TOKEN_COMMA)) {
                 advance_parser(parser);
@@ -629,26 +685,25 @@ static ASTNode *parse_function_call(Parser *parser) {
         } while (1);
     }
     
-    ASTNode *node = create_ast_node(AST_FUNCTION_CALL, token->line, token->column);
-    node->data.function_call.function_name = strdup(func_name->value);
-    node->data.function_call.arguments = arguments;
-    node->data.function_call.arg_count = arg_count;
-    node->data.function_call.result_vars = result_vars;
-    node->data.function_call.result_count = result_count;
+    ASTNode *node = create_ast_node(parser->arena, AST_FUNCTION_CALL, token.line, token.column);
+    node->data.function_call.function_name = func_name.symbol;
+    node->data.function_call.arg_count = arguments.count;
+    node->data.function_call.arguments = list_finish(parser, &arguments);
+    node->data.function_call.result_count = result_vars.count;
+    node->data.function_call.result_vars = int_list_finish(parser, &result_vars);
     return node;
 }
 
 // Parse return statement: ret x,y,z
 static ASTNode *parse_return(Parser *parser) {
-    Token *token = current_token(parser);
+    Token token = *current_token(parser);
     advance_parser(parser); // skip 'ret'
     
-    ASTNode **values = malloc(sizeof(ASTNode*) * 50);
-    int value_count = 0;
+    PtrList values = {0};
     
     // Parse return values
     while (!match(parser, TOKEN_NEWLINE) && !match(parser, TOKEN_EOF)) {
-        values[value_count++] = parse_expression(parser);
+        list_push(&values, parse_expression(parser));
         
         if (match(parser, TOKEN_COMMA)) {
             advance_parser(parser);
@@ -657,16 +712,16 @@ static ASTNode *parse_return(Parser *parser) {
         }
     }
     
-    ASTNode *node = create_ast_node(AST_RETURN, token->line, token->column);
-    node->data.return_stmt.values = values;
-    node->data.return_stmt.value_count = value_count;
+    ASTNode *node = create_ast_node(parser->arena, AST_RETURN, token.line, token.column);
+    node->data.return_stmt.value_count = values.count;
+    node->data.return_stmt.values = list_finish(parser, &values);
     return node;
 }
 
 // Parse jump: jmp .label, jeq x,y .label
 static ASTNode *parse_jump(Parser *parser) {
-    Token *token = current_token(parser);
-    TokenType jump_type = token->type;
+    Token token = *current_token(parser);
+    TokenType jump_type = token.type;
     advance_parser(parser);
     
     ASTNode *left = NULL;
@@ -679,60 +734,59 @@ static ASTNode *parse_jump(Parser *parser) {
         right = parse_expression(parser);
     }
     
-    Token *label = consume(parser, TOKEN_LABEL, "Expected label for jump");
+    Token label = consume(parser, TOKEN_LABEL, "Expected label for jump");
     
-    ASTNode *node = create_ast_node(AST_JUMP, token->line, token->column);
+    ASTNode *node = create_ast_node(parser->arena, AST_JUMP, token.line, token.column);
     node->data.jump.jump_type = jump_type;
     node->data.jump.left = left;
     node->data.jump.right = right;
-    node->data.jump.target_label = strdup(label->value);
+    node->data.jump.target_label = label.symbol;
     return node;
 }
 
 // Parse type check: type x or type t eq x
 static ASTNode *parse_type_check(Parser *parser) {
-    Token *token = current_token(parser);
+    Token token = *current_token(parser);
     advance_parser(parser); // skip 'type'
     
-    char *result_var = NULL;
-    char *variable = NULL;
+    int result_var = NO_SYMBOL;
+    int variable = NO_SYMBOL;
     
     // Check format: type t eq x or type x
-    Token *first = consume(parser, TOKEN_IDENTIFIER, "Expected variable name");
+    Token first = consume(parser, TOKEN_IDENTIFIER, "Expected variable name");
     
     if (match(parser, TOKEN_EQ)) {
         // type t eq x
-        result_var = strdup(first->value);
+        result_var = first.symbol;
         advance_parser(parser);
-        Token *var = consume(parser, TOKEN_IDENTIFIER, "Expected variable name after 'eq'");
-        variable = strdup(var->value);
+        Token var = consume(parser, TOKEN_IDENTIFIER, "Expected variable name after 'eq'");
+        variable = var.symbol;
     } else {
         // type x
-        variable = strdup(first->value);
-        result_var = NULL;
+        variable = first.symbol;
+        result_var = NO_SYMBOL;
     }
     
-    ASTNode *node = create_ast_node(AST_TYPE_CHECK, token->line, token->column);
-    node->data.type_check.variable = variable;
-    node->data.type_check.result_var = result_var;
+    ASTNode *node = create_ast_node(parser->arena, AST_TYPE_CHECK, token.line, token.column);
+    node->data.type_check.variable.symbol = variable;
+    node->data.type_check.result_var.symbol = result_var;
     return node;
 }
 
 // Parse function definition
 static ASTNode *parse_function(Parser *parser) {
-    Token *token = current_token(parser);
+    Token token = *current_token(parser);
     
-    Token *func_name = consume(parser, TOKEN_LABEL, "Expected function name");
+    Token func_name = consume(parser, TOKEN_LABEL, "Expected function name");
     
     // Parse parameters
     consume(parser, TOKEN_LPAREN, "Expected '(' after function name");
     
-    char **parameters = malloc(sizeof(char*) * 50);
-    int param_count = 0;
+    IntList parameters = {0};
     
     while (!match(parser, TOKEN_RPAREN) && !match(parser, TOKEN_EOF)) {
-        Token *param = consume(parser, TOKEN_IDENTIFIER, "Expected parameter name");
-        parameters[param_count++] = strdup(param->value);
+        Token param = consume(parser, TOKEN_IDENTIFIER, "Expected parameter name");
+        int_list_push(&parameters, param.symbol);
         
         if (match(parser, TOKEN_COMMA)) {
             advance_parser(parser);
@@ -741,30 +795,36 @@ static ASTNode *parse_function(Parser *parser) {
     
     consume(parser, TOKEN_RPAREN, "Expected ')' after parameters");
     
-    // Parse function body (until we hit another function, start, or EOF)
-    ASTNode **body = malloc(sizeof(ASTNode*) * 200);
-    int body_count = 0;
-    
-    while (!match(parser, TOKEN_LABEL) && !match(parser, TOKEN_START) && !match(parser, TOKEN_EOF)) {
-        body[body_count++] = parse_statement(parser);
+    // Parse function body (until we hit another function, start, or EOF);
+    // a label on its own is a jump target inside the body
+    PtrList body = {0};
+    while (1) {
+        while (match(parser, TOKEN_NEWLINE)) {
+            advance_parser(parser);
+        }
+        if (match(parser, TOKEN_EOF) || match(parser, TOKEN_START) ||
+            (match(parser, TOKEN_LABEL) && peek_token(parser, 1)->type == TOKEN_LPAREN)) {
+            break;
+        }
+        list_push(&body, parse_statement(parser));
     }
     
-    ASTNode *node = create_ast_node(AST_FUNCTION, token->line, token->column);
-    node->data.function.name = strdup(func_name->value);
-    node->data.function.parameters = parameters;
-    node->data.function.param_count = param_count;
-    node->data.function.body = body;
-    node->data.function.body_count = body_count;
+    ASTNode *node = create_ast_node(parser->arena, AST_FUNCTION, token.line, token.column);
+    node->data.function.name = func_name.symbol;
+    node->data.function.param_count = parameters.count;
+    node->data.function.parameters = int_list_finish(parser, &parameters);
+    node->data.function.body_count = body.count;
+    node->data.function.body = list_finish(parser, &body);
     return node;
 }
 
 // Parse label definition
 static ASTNode *parse_label_def(Parser *parser) {
-    Token *token = current_token(parser);
+    Token token = *current_token(parser);
     advance_parser(parser);
     
-    ASTNode *node = create_ast_node(AST_LABEL, token->line, token->column);
-    node->data.label.name = strdup(token->value);
+    ASTNode *node = create_ast_node(parser->arena, AST_LABEL, token.line, token.column);
+    node->data.label.name = token.symbol;
     return node;
 }
 
@@ -780,7 +840,7 @@ static ASTNode *parse_statement(Parser *parser) {
         return NULL;
     }
     
-    Token *token = current_token(parser);
+    Token token = *current_token(parser);
     
     // Assignment
     if (match(parser, TOKEN_SET)) {
@@ -850,22 +910,43 @@ static ASTNode *parse_statement(Parser *parser) {
     // Operations without assignment (just for side effects in conditions)
     if (match(parser, TOKEN_ADD) || match(parser, TOKEN_SUB) || 
         match(parser, TOKEN_MUL) || match(parser, TOKEN_DIV) || 
-        match(parser, TOKEN_MOD)) {
+        match(parser, TOKEN_MOD) || match(parser, TOKEN_CONCAT)) {
+        return parse_expression(parser);
+    }
+    
+    // Type cast into a variable: int x eq y
+    if (match(parser, TOKEN_INT_CAST) || match(parser, TOKEN_FLOAT_CAST) ||
+        match(parser, TOKEN_STR_CAST) || match(parser, TOKEN_BOOL_CAST)) {
         return parse_expression(parser);
     }
     
     fprintf(stderr, "Parse Error [%d:%d]: Unexpected token %s in statement\n",
-            token->line, token->column, token_type_name(token->type));
+            token.line, token.column, token_type_name(token.type));
     exit(1);
 }
 
-// Main parse function
-ASTNode *parse(Token **tokens, int token_count) {
-    Parser *parser = create_parser(tokens, token_count);
+// Parse statements until a terminator token (or EOF), skipping blank lines
+static ASTNode **parse_block(Parser *parser, TokenType *terminators, int terminator_count, int *count) {
+    PtrList statements = {0};
     
-    ASTNode *program = create_ast_node(AST_PROGRAM, 1, 0);
-    ASTNode **statements = malloc(sizeof(ASTNode*) * 1000);
-    int statement_count = 0;
+    while (1) {
+        while (match(parser, TOKEN_NEWLINE)) {
+            advance_parser(parser);
+        }
+        if (match(parser, TOKEN_EOF) || match_any(parser, terminators, terminator_count)) {
+            break;
+        }
+        list_push(&statements, parse_statement(parser));
+    }
+    
+    *count = statements.count;
+    return list_finish(parser, &statements);
+}
+
+// Parse a whole program from the parser's token source
+static ASTNode *parse_program(Parser *parser) {
+    ASTNode *program = create_ast_node(parser->arena, AST_PROGRAM, 1, 0);
+    PtrList statements = {0};
     
     // Skip initial newlines
     while (match(parser, TOKEN_NEWLINE)) {
@@ -874,18 +955,16 @@ ASTNode *parse(Token **tokens, int token_count) {
     
     // Parse the program
     while (!match(parser, TOKEN_EOF)) {
-        Token *token = current_token(parser);
-        
         // Function definition: .funcName(params)
         if (match(parser, TOKEN_LABEL) && peek_token(parser, 1)->type == TOKEN_LPAREN) {
-            statements[statement_count++] = parse_function(parser);
+            list_push(&statements, parse_function(parser));
         }
         // Start main
         else if (match(parser, TOKEN_START)) {
             advance_parser(parser); // skip 'start'
-            Token *main_label = consume(parser, TOKEN_LABEL, "Expected .main after 'start'");
+            Token main_label = consume(parser, TOKEN_LABEL, "Expected .main after 'start'");
             
-            if (strcmp(main_label->value, ".main") != 0) {
+            if (!token_equals(&main_label, ".main")) {
                 fprintf(stderr, "Parse Error: Expected '.main' after 'start'\n");
                 exit(1);
             }
@@ -894,7 +973,7 @@ ASTNode *parse(Token **tokens, int token_count) {
             !(match(parser, TOKEN_LABEL) && peek_token(parser, 1)->type == TOKEN_LPAREN)) {
             ASTNode *stmt = parse_statement(parser);
             if (stmt != NULL) {
-                 statements[statement_count++] = stmt;
+                 list_push(&statements, stmt);
             }
         }
         }
@@ -903,21 +982,27 @@ ASTNode *parse(Token **tokens, int token_count) {
         }
     }
     
-    program->data.program.statements = statements;
-    program->data.program.statement_count = statement_count;
-    
+    program->data.program.statement_count = statements.count;
+    program->data.program.statements = list_finish(parser, &statements);
+    return program;
+}
+
+// Main parse function
+ASTNode *parse(Token *tokens, int token_count, Arena *arena) {
+    Parser *parser = create_parser(tokens, token_count, arena);
+    ASTNode *program = parse_program(parser);
     free_parser(parser);
     return program;
 }
 
-// Free AST node (recursive)
-void free_ast_node(ASTNode *node) {
-    if (!node) return;
-    
-    // TODO: Free all nested nodes and allocated strings
-    // This is complex, implement as needed
-    
-    free(node);
+// Parse straight from source, lexing tokens only as the parser needs them
+ASTNode *parse_source(const char *source, size_t length, Arena *arena) {
+    Lexer *lexer = create_lexer(source, length);
+    Parser *parser = create_streaming_parser(lexer, arena);
+    ASTNode *program = parse_program(parser);
+    free_parser(parser);
+    free_lexer(lexer);
+    return program;
 }
 
 // Print AST (for debugging)
@@ -944,7 +1029,7 @@ void print_ast(ASTNode *node, int indent) {
             break;
             
         case AST_ASSIGNMENT:
-            printf("ASSIGNMENT: %s = ", node->data.assignment.variable ? node->data.assignment.variable : "(null var)");
+            printf("ASSIGNMENT: %s = ", symbol_name(node->data.assignment.variable.symbol));
             if (node->data.assignment.value) {
                 printf("\n");
                 print_ast(node->data.assignment.value, indent + 1);
@@ -982,13 +1067,13 @@ void print_ast(ASTNode *node, int indent) {
             break;
             
         case AST_IDENTIFIER:
-            printf("IDENTIFIER: %s\n", node->data.identifier.name ? node->data.identifier.name : "(null)");
+            printf("IDENTIFIER: %s\n", symbol_name(node->data.identifier.name.symbol));
             break;
             
         case AST_BINARY_OP:
             printf("BINARY_OP: %s", token_type_name(node->data.binary_op.op));
-            if (node->data.binary_op.result) {
-                printf(" -> %s", node->data.binary_op.result);
+            if (node->data.binary_op.result.symbol != NO_SYMBOL) {
+                printf(" -> %s", symbol_name(node->data.binary_op.result.symbol));
             }
             printf("\n");
             if (node->data.binary_op.left) {
@@ -1014,7 +1099,7 @@ void print_ast(ASTNode *node, int indent) {
             break;
             
         case AST_FOR_LOOP:
-            printf("FOR_LOOP: %s\n", node->data.for_loop.variable ? node->data.for_loop.variable : "(null)");
+            printf("FOR_LOOP: %s\n", symbol_name(node->data.for_loop.variable.symbol));
             break;
             
         case AST_IF_STATEMENT:
@@ -1022,7 +1107,7 @@ void print_ast(ASTNode *node, int indent) {
             break;
             
         case AST_LABEL:
-            printf("LABEL: %s\n", node->data.label.name ? node->data.label.name : "(null)");
+            printf("LABEL: %s\n", symbol_name(node->data.label.name));
             break;
             
         default:
@@ -2,29 +2,45 @@
 #define PARSER_H
 
 #include "token.h"
+#include "lexer.h"
 #include "ast.h"
+#include "arena.h"
+
+// Lookahead ring size (power of two); bounds the peek_token() offset
+#define PARSER_LOOKAHEAD 8
 
 typedef struct {
-    Token **tokens;
+    Arena *arena;               // Owns every node the parser creates
+    Lexer *lexer;               // Streaming source (NULL for token arrays)
+    Token *tokens;              // Pre-tokenized source
     int token_count;
-    int current;
+    int next_index;             // Next array token to load into the ring
+    Token ring[PARSER_LOOKAHEAD];
+    int head;                   // Ring slot of the current token
+    int buffered;               // Tokens loaded from head onwards
 } Parser;
 
-// Create parser
-Parser *create_parser(Token **tokens, int token_count);
+// Create parser over a token array
+Parser *create_parser(Token *tokens, int token_count, Arena *arena);
+
+// Create parser that pulls tokens from a lexer
+Parser *create_streaming_parser(Lexer *lexer, Arena *arena);
 
 // Free parser
 void free_parser(Parser *parser);
 
-// Parse tokens into AST
-ASTNode *parse(Token **tokens, int token_count);
+// Parse tokens into AST (nodes live until the arena is freed)
+ASTNode *parse(Token *tokens, int token_count, Arena *arena);
+
+// Parse source into AST, lexing on demand
+ASTNode *parse_source(const char *source, size_t length, Arena *arena);
 
-// Helper functions
+// Helper functions (returned tokens stay valid until the next advance)
 Token *current_token(Parser *parser);
 Token *peek_token(Parser *parser, int offset);
 void advance_parser(Parser *parser);
 int match(Parser *parser, TokenType type);
 int match_any(Parser *parser, TokenType *types, int count);
-Token *consume(Parser *parser, TokenType type, const char *error_message);
+Token consume(Parser *parser, TokenType type, const char *error_message);
 
 #endif
@@ -0,0 +1,296 @@
+#include "resolver.h"
+#include "symbol.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Statement lists enclosing the statement being resolved, innermost first
+typedef struct Block {
+    ASTNode **body;
+    struct Block *outer;
+} Block;
+
+// Slot assignments for the frame currently being resolved
+typedef struct {
+    int *slot_of;        // symbol ID -> slot, or -1 if not in this frame
+    int *assigned;       // symbols that received a slot (for reset)
+    int slot_count;
+    Arena *arena;
+    ASTNode **label_of;  // symbol ID -> AST_LABEL in this frame, or NULL
+    int *labels;         // symbols of this frame's labels (for reset)
+    int label_count;
+    Block *block;        // innermost statement list being resolved
+    int site_count;      // binary operations numbered so far (whole program)
+    int errors;
+} Scope;
+
+// Get the slot for a symbol, assigning the next free one on first use
+static int slot_for(Scope *scope, int symbol) {
+    if (scope->slot_of[symbol] < 0) {
+        scope->assigned[scope->slot_count] = symbol;
+        scope->slot_of[symbol] = scope->slot_count++;
+    }
+    return scope->slot_of[symbol];
+}
+
+static void resolve_ref(Scope *scope, VarRef *ref) {
+    ref->slot = ref->symbol != NO_SYMBOL ? slot_for(scope, ref->symbol) : -1;
+}
+
+// Start a fresh frame
+static void reset_scope(Scope *scope) {
+    for (int i = 0; i < scope->slot_count; i++) {
+        scope->slot_of[scope->assigned[i]] = -1;
+    }
+    scope->slot_count = 0;
+    
+    for (int i = 0; i < scope->label_count; i++) {
+        scope->label_of[scope->labels[i]] = NULL;
+    }
+    scope->label_count = 0;
+}
+
+// Record where every label of a frame sits before any jump is resolved,
+// so jumps can point forward
+static void collect_labels(Scope *scope, ASTNode **body, int count) {
+    for (int i = 0; i < count; i++) {
+        ASTNode *node = body[i];
+        switch (node->type) {
+            case AST_LABEL: {
+                int name = node->data.label.name;
+                if (scope->label_of[name]) {
+                    fprintf(stderr, "Link Error [%d:%d]: Label '%s' is already defined\n",
+                            node->line, node->column, symbol_name(name));
+                    scope->errors++;
+                    break;
+                }
+                scope->label_of[name] = node;
+                scope->labels[scope->label_count++] = name;
+                node->data.label.block = body;
+                node->data.label.index = i;
+                break;
+            }
+            
+            case AST_IF_STATEMENT:
+                collect_labels(scope, node->data.if_stmt.then_body, node->data.if_stmt.then_count);
+                collect_labels(scope, node->data.if_stmt.else_body, node->data.if_stmt.else_count);
+                break;
+            
+            case AST_FOR_LOOP:
+                collect_labels(scope, node->data.for_loop.body, node->data.for_loop.body_count);
+                break;
+            
+            case AST_WHILE_LOOP:
+                collect_labels(scope, node->data.while_loop.body, node->data.while_loop.body_count);
+                break;
+            
+            default:
+                // Function bodies are separate frames
+                break;
+        }
+    }
+}
+
+static void resolve_node(Scope *scope, ASTNode *node);
+
+static void resolve_block(Scope *scope, ASTNode **body, int count) {
+    for (int i = 0; i < count; i++) {
+        resolve_node(scope, body[i]);
+    }
+}
+
+// Resolve a statement list (frame, if, for or while body), tracking it as
+// one that jumps inside it may target
+static void resolve_body(Scope *scope, ASTNode **body, int count) {
+    Block block = { body, scope->block };
+    scope->block = &block;
+    resolve_block(scope, body, count);
+    scope->block = block.outer;
+}
+
+// Is this statement list the current one or one enclosing it?
+static int block_is_open(Scope *scope, ASTNode **body) {
+    for (Block *block = scope->block; block; block = block->outer) {
+        if (block->body == body) return 1;
+    }
+    return 0;
+}
+
+static void resolve_node(Scope *scope, ASTNode *node) {
+    if (!node) return;
+    
+    switch (node->type) {
+        case AST_ASSIGNMENT:
+            resolve_node(scope, node->data.assignment.value);
+            resolve_ref(scope, &node->data.assignment.variable);
+            break;
+        
+        case AST_BINARY_OP:
+            node->data.binary_op.site = scope->site_count++;
+            resolve_node(scope, node->data.binary_op.left);
+            resolve_node(scope, node->data.binary_op.right);
+            resolve_ref(scope, &node->data.binary_op.result);
+            break;
+        
+        case AST_UNARY_OP:
+            resolve_ref(scope, &node->data.unary_op.variable);
+            resolve_node(scope, node->data.unary_op.amount);
+            break;
+        
+        case AST_IF_STATEMENT:
+            resolve_node(scope, node->data.if_stmt.condition);
+            resolve_body(scope, node->data.if_stmt.then_body, node->data.if_stmt.then_count);
+            resolve_body(scope, node->data.if_stmt.else_body, node->data.if_stmt.else_count);
+            break;
+        
+        case AST_FOR_LOOP:
+            resolve_ref(scope, &node->data.for_loop.variable);
+            resolve_node(scope, node->data.for_loop.start);
+            resolve_node(scope, node->data.for_loop.end);
+            resolve_node(scope, node->data.for_loop.step);
+            resolve_body(scope, node->data.for_loop.body, node->data.for_loop.body_count);
+            break;
+        
+        case AST_WHILE_LOOP:
+            resolve_node(scope, node->data.while_loop.condition);
+            resolve_body(scope, node->data.while_loop.body, node->data.while_loop.body_count);
+            break;
+        
+        case AST_FUNCTION_CALL: {
+            resolve_block(scope, node->data.function_call.arguments, node->data.function_call.arg_count);
+            int count = node->data.function_call.result_count;
+            int *slots = count ? arena_alloc(scope->arena, sizeof(int) * count) : NULL;
+            for (int i = 0; i < count; i++) {
+                slots[i] = slot_for(scope, node->data.function_call.result_vars[i]);
+            }
+            node->data.function_call.result_slots = slots;
+            break;
+        }
+        
+        case AST_RETURN:
+            resolve_block(scope, node->data.return_stmt.values, node->data.return_stmt.value_count);
+            break;
+        
+        case AST_JUMP: {
+            resolve_node(scope, node->data.jump.left);
+            resolve_node(scope, node->data.jump.right);
+            ASTNode *target = scope->label_of[node->data.jump.target_label];
+            node->data.jump.target = target;
+            if (!target) {
+                fprintf(stderr, "Link Error [%d:%d]: Undefined label '%s'\n",
+                        node->line, node->column, symbol_name(node->data.jump.target_label));
+                scope->errors++;
+            } else if (!block_is_open(scope, target->data.label.block)) {
+                // Entering an if/for/while body sideways would skip its
+                // condition or loop setup
+                fprintf(stderr, "Link Error [%d:%d]: Cannot jump into the block holding '%s'\n",
+                        node->line, node->column, symbol_name(node->data.jump.target_label));
+                scope->errors++;
+            }
+            break;
+        }
+        
+        case AST_ECHO:
+            resolve_block(scope, node->data.echo.expressions, node->data.echo.expr_count);
+            break;
+        
+        case AST_HALT:
+            resolve_node(scope, node->data.halt.message);
+            break;
+        
+        case AST_TYPE_CHECK:
+            resolve_ref(scope, &node->data.type_check.variable);
+            resolve_ref(scope, &node->data.type_check.result_var);
+            break;
+        
+        case AST_TYPE_CAST:
+            resolve_node(scope, node->data.type_cast.value);
+            resolve_ref(scope, &node->data.type_cast.result_var);
+            break;
+        
+        case AST_IDENTIFIER:
+            resolve_ref(scope, &node->data.identifier.name);
+            break;
+        
+        case AST_ARRAY:
+            resolve_block(scope, node->data.array.elements, node->data.array.element_count);
+            break;
+        
+        case AST_ARRAY_ACCESS:
+            resolve_ref(scope, &node->data.array_access.array_name);
+            resolve_node(scope, node->data.array_access.index);
+            break;
+        
+        case AST_PROPERTY_ACCESS:
+            resolve_ref(scope, &node->data.property_access.object_name);
+            break;
+        
+        case AST_INPUT:
+            resolve_node(scope, node->data.input.prompt);
+            break;
+        
+        default:
+            // Literals, labels, break/continue: no variables
+            break;
+    }
+}
+
+int resolve(ASTNode *program, Arena *arena) {
+    int symbols = symbol_count() + 1;
+    Scope scope;
+    scope.slot_of = malloc(sizeof(int) * symbols);
+    scope.assigned = malloc(sizeof(int) * symbols);
+    scope.slot_count = 0;
+    scope.arena = arena;
+    scope.label_of = calloc(symbols, sizeof(ASTNode*));
+    scope.labels = malloc(sizeof(int) * symbols);
+    scope.label_count = 0;
+    scope.block = NULL;
+    scope.site_count = 0;
+    scope.errors = 0;
+    for (int i = 0; i < symbols; i++) {
+        scope.slot_of[i] = -1;
+    }
+    
+    ASTNode **statements = program->data.program.statements;
+    int count = program->data.program.statement_count;
+    
+    // .main: every top-level statement that is not a function definition
+    collect_labels(&scope, statements, count);
+    Block main_block = { statements, NULL };
+    scope.block = &main_block;
+    for (int i = 0; i < count; i++) {
+        if (statements[i]->type != AST_FUNCTION) {
+            resolve_node(&scope, statements[i]);
+        }
+    }
+    scope.block = NULL;
+    program->data.program.slot_count = scope.slot_count;
+    
+    // Each function gets its own frame, parameters first
+    for (int i = 0; i < count; i++) {
+        ASTNode *func = statements[i];
+        if (func->type != AST_FUNCTION) continue;
+        
+        reset_scope(&scope);
+        for (int p = 0; p < func->data.function.param_count; p++) {
+            int name = func->data.function.parameters[p];
+            if (scope.slot_of[name] >= 0) {
+                // Every parameter needs its own slot: arguments are stored by position
+                fprintf(stderr, "Link Error [%d:%d]: Parameter '%s' is already defined\n",
+                        func->line, func->column, symbol_name(name));
+                scope.errors++;
+            }
+            slot_for(&scope, name);
+        }
+        collect_labels(&scope, func->data.function.body, func->data.function.body_count);
+        resolve_body(&scope, func->data.function.body, func->data.function.body_count);
+        func->data.function.slot_count = scope.slot_count;
+    }
+    program->data.program.site_count = scope.site_count;
+    
+    free(scope.slot_of);
+    free(scope.assigned);
+    free(scope.label_of);
+    free(scope.labels);
+    return scope.errors;
+}
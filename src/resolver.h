@@ -0,0 +1,15 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include "ast.h"
+#include "arena.h"
+
+// Resolver pass (runs between parse() and interpret()).
+// Gives every variable a slot index in its frame: .main has one frame and
+// each function has its own, with parameters in the first slots. The
+// interpreter then reads and writes variables by index instead of by name.
+// Jumps are pointed at their label in the same frame; undefined and
+// duplicate labels are reported. Returns the number of errors.
+int resolve(ASTNode *program, Arena *arena);
+
+#endif
@@ -0,0 +1,101 @@
+#include "symbol.h"
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+typedef struct {
+    const char *name;
+    int length;
+    uint32_t hash;
+} Symbol;
+
+// Symbols by ID, plus an open-addressed index of IDs by name hash
+static Symbol *symbols;          // symbols[0] is unused (NO_SYMBOL)
+static int count;
+static int capacity;
+static int *index_table;         // 0 = empty slot
+static int index_size;
+static Arena *names;
+
+// FNV-1a over the name slice
+static uint32_t hash_name(const char *name, int length) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Rebuild the index at twice the size
+static void grow_index(void) {
+    int new_size = index_size ? index_size * 2 : 256;
+    int *table = calloc(new_size, sizeof(int));
+    
+    for (int id = 1; id <= count; id++) {
+        uint32_t slot = symbols[id].hash & (new_size - 1);
+        while (table[slot]) {
+            slot = (slot + 1) & (new_size - 1);
+        }
+        table[slot] = id;
+    }
+    
+    free(index_table);
+    index_table = table;
+    index_size = new_size;
+}
+
+int intern_symbol(const char *name, int length) {
+    // Keep the index at most half full
+    if ((count + 1) * 2 > index_size) {
+        grow_index();
+    }
+    
+    uint32_t hash = hash_name(name, length);
+    uint32_t slot = hash & (index_size - 1);
+    
+    while (index_table[slot]) {
+        Symbol *sym = &symbols[index_table[slot]];
+        if (sym->hash == hash && sym->length == length &&
+            memcmp(sym->name, name, length) == 0) {
+            return index_table[slot];
+        }
+        slot = (slot + 1) & (index_size - 1);
+    }
+    
+    // New symbol
+    if (count + 1 >= capacity) {
+        capacity = capacity ? capacity * 2 : 256;
+        symbols = realloc(symbols, sizeof(Symbol) * capacity);
+    }
+    if (!names) {
+        names = create_arena(16 * 1024);
+    }
+    
+    int id = ++count;
+    symbols[id].name = arena_strndup(names, name, length);
+    symbols[id].length = length;
+    symbols[id].hash = hash;
+    index_table[slot] = id;
+    return id;
+}
+
+const char *symbol_name(int symbol) {
+    if (symbol <= NO_SYMBOL || symbol > count) return "(none)";
+    return symbols[symbol].name;
+}
+
+int symbol_count(void) {
+    return count;
+}
+
+void free_symbols(void) {
+    free(symbols);
+    free(index_table);
+    free_arena(names);
+    symbols = NULL;
+    index_table = NULL;
+    names = NULL;
+    count = capacity = index_size = 0;
+}
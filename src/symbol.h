@@ -0,0 +1,23 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+// Global identifier interner. Every distinct name (variables, labels,
+// function names) is stored once and mapped to a small integer ID, so
+// later stages compare and index by ID instead of by string.
+
+// IDs start at 1; 0 marks an absent name (e.g. no result variable)
+#define NO_SYMBOL 0
+
+// Intern a name slice, returning its ID (the same ID for the same text)
+int intern_symbol(const char *name, int length);
+
+// Name for an ID (NUL-terminated, valid until free_symbols)
+const char *symbol_name(int symbol);
+
+// Number of IDs handed out so far (IDs are 1..symbol_count())
+int symbol_count(void);
+
+// Release the table
+void free_symbols(void);
+
+#endif
@@ -86,18 +86,22 @@ typedef enum {
 
 typedef struct {
     TokenType type;
-    char *value;         // String representation
+    const char *start;   // Slice of the source text (not NUL-terminated)
+    int length;          // Length of the slice
+    int symbol;          // Interned ID for identifiers and labels (else NO_SYMBOL)
     int line;            // Line number
     int column;          // Column number
 } Token;
 
-// Function to create a new token
-Token *create_token(TokenType type, const char *value, int line, int column);
+// Compare token text with a NUL-terminated string
+int token_equals(const Token *token, const char *text);
 
-// Function to free token memory
-void free_token(Token *token);
+// Convert numeric token text. token_int_value() returns 0 when the
+// literal does not fit in an int.
+int token_int_value(const Token *token, int *value);
+double token_float_value(const Token *token);
 
 // Function to get token type name (for debugging)
 const char *token_type_name(TokenType type);
-// Already have the definitions, just making sure these are declared
+
 #endif
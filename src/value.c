@@ -0,0 +1,364 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "value.h"
+#include "number.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(Value) == 16, "Value should stay a 16-byte tagged union");
+
+static StringObject *allocate_string(int length, int capacity) {
+    StringObject *string = malloc(sizeof(StringObject) + capacity + 1);
+    string->refcount = 1;
+    string->length = length;
+    string->capacity = capacity;
+    return string;
+}
+
+Value string_value_n(const char *val, int length) {
+    StringObject *string = allocate_string(length, length);
+    memcpy(string->chars, val, length);
+    string->chars[length] = '\0';
+    
+    Value v = {VAL_STRING, {.string_val = string}};
+    return v;
+}
+
+Value string_value(const char *val) {
+    return string_value_n(val, (int)strlen(val));
+}
+
+Value array_value(int count) {
+    ArrayObject *array = malloc(sizeof(ArrayObject) + sizeof(Value) * count);
+    array->refcount = 1;
+    array->count = count;
+    for (int i = 0; i < count; i++) {
+        array->elements[i] = null_value();
+    }
+    
+    Value v = {VAL_ARRAY, {.array_val = array}};
+    return v;
+}
+
+void release_value(Value val) {
+    if (val.type == VAL_STRING) {
+        if (--val.data.string_val->refcount == 0) {
+            free(val.data.string_val);
+        }
+    } else if (val.type == VAL_ARRAY) {
+        ArrayObject *array = val.data.array_val;
+        if (--array->refcount == 0) {
+            for (int i = 0; i < array->count; i++) {
+                release_value(array->elements[i]);
+            }
+            free(array);
+        }
+    }
+}
+
+StringObject *string_for_write(Value *val) {
+    StringObject *string = val->data.string_val;
+    if (string->refcount > 1) {
+        *val = string_value_n(string->chars, string->length);
+        string->refcount--;
+    }
+    return val->data.string_val;
+}
+
+ArrayObject *array_for_write(Value *val) {
+    ArrayObject *array = val->data.array_val;
+    if (array->refcount > 1) {
+        // Shallow copy: elements are shared, not duplicated
+        Value copy = array_value(array->count);
+        for (int i = 0; i < array->count; i++) {
+            copy.data.array_val->elements[i] = retain_value(array->elements[i]);
+        }
+        array->refcount--;
+        *val = copy;
+    }
+    return val->data.array_val;
+}
+
+void string_append(Value *val, const char *chars, int length) {
+    StringObject *string = val->data.string_val;
+    int needed = string->length + length;
+    
+    if (string->refcount > 1 || needed > string->capacity) {
+        int capacity = string->capacity * 2;
+        if (capacity < needed) capacity = needed;
+        if (capacity < 16) capacity = 16;
+        
+        if (string->refcount > 1) {
+            StringObject *copy = allocate_string(string->length, capacity);
+            memcpy(copy->chars, string->chars, string->length);
+            string->refcount--;
+            string = copy;
+        } else {
+            string = realloc(string, sizeof(StringObject) + capacity + 1);
+            string->capacity = capacity;
+        }
+        val->data.string_val = string;
+    }
+    
+    memcpy(string->chars + string->length, chars, length);
+    string->length = needed;
+    string->chars[needed] = '\0';
+}
+
+// Room for the text of any scalar
+#define SCALAR_TEXT_SIZE 32
+
+// Text form of a value, pointing into buffer for scalars; 0 if it has none
+static int value_text(Value val, char *buffer, const char **chars, int *length) {
+    switch (val.type) {
+        case VAL_STRING:
+            *chars = val.data.string_val->chars;
+            *length = val.data.string_val->length;
+            return 1;
+        case VAL_INT: *length = snprintf(buffer, SCALAR_TEXT_SIZE, "%d", val.data.int_val); break;
+        case VAL_FLOAT: *length = format_double(val.data.float_val, buffer); break;
+        case VAL_BOOL: *length = snprintf(buffer, SCALAR_TEXT_SIZE, "%s", val.data.bool_val ? "true" : "false"); break;
+        case VAL_NULL: *length = snprintf(buffer, SCALAR_TEXT_SIZE, "null"); break;
+        default: return 0;
+    }
+    *chars = buffer;
+    return 1;
+}
+
+int concat_values(Value *dst, Value left, Value right) {
+    char left_buffer[SCALAR_TEXT_SIZE], right_buffer[SCALAR_TEXT_SIZE];
+    const char *left_chars, *right_chars;
+    int left_length, right_length;
+    if (!value_text(left, left_buffer, &left_chars, &left_length) ||
+        !value_text(right, right_buffer, &right_chars, &right_length)) {
+        return 0;
+    }
+    
+    // concat s,x eq s: grow s itself (unless x is s, which a move would invalidate)
+    if (left.type == VAL_STRING && dst->type == VAL_STRING &&
+        dst->data.string_val == left.data.string_val &&
+        (right.type != VAL_STRING || right.data.string_val != left.data.string_val)) {
+        string_append(dst, right_chars, right_length);
+        return 1;
+    }
+    
+    StringObject *string = allocate_string(left_length + right_length, left_length + right_length);
+    memcpy(string->chars, left_chars, left_length);
+    memcpy(string->chars + left_length, right_chars, right_length);
+    string->chars[string->length] = '\0';
+    
+    Value old = *dst;
+    dst->type = VAL_STRING;
+    dst->data.string_val = string;
+    release_value(old);
+    return 1;
+}
+
+int strings_equal(Value a, Value b) {
+    StringObject *l = a.data.string_val;
+    StringObject *r = b.data.string_val;
+    return l == r || (l->length == r->length && memcmp(l->chars, r->chars, l->length) == 0);
+}
+
+// Where the left operand sorts relative to the right
+typedef enum {
+    ORDER_LESS,
+    ORDER_EQUAL,
+    ORDER_GREATER,
+    ORDER_UNORDERED      // a NaN is involved: only ne holds
+} Order;
+
+typedef Order (*OrderKernel)(Value left, Value right);
+
+static Order order_ints(int a, int b) {
+    return (Order)(1 + (a > b) - (a < b));
+}
+
+static Order order_doubles(double a, double b) {
+    int less = a < b;
+    int equal = a == b;
+    int greater = a > b;
+    return (Order)(equal + 2 * greater + 3 * !(less | equal | greater));
+}
+
+static Order order_int_int(Value left, Value right) {
+    return order_ints(left.data.int_val, right.data.int_val);
+}
+
+static Order order_float_float(Value left, Value right) {
+    return order_doubles(left.data.float_val, right.data.float_val);
+}
+
+static Order order_int_float(Value left, Value right) {
+    return order_doubles(left.data.int_val, right.data.float_val);
+}
+
+static Order order_float_int(Value left, Value right) {
+    return order_doubles(left.data.float_val, right.data.int_val);
+}
+
+static Order order_string_string(Value left, Value right) {
+    StringObject *l = left.data.string_val;
+    StringObject *r = right.data.string_val;
+    int shared = l->length < r->length ? l->length : r->length;
+    int c = memcmp(l->chars, r->chars, shared);
+    if (c == 0) return order_ints(l->length, r->length);
+    return c < 0 ? ORDER_LESS : ORDER_GREATER;
+}
+
+static Order order_bool_bool(Value left, Value right) {
+    return order_ints(left.data.bool_val, right.data.bool_val);
+}
+
+static Order order_null_null(Value left, Value right) {
+    (void)left;
+    (void)right;
+    return ORDER_EQUAL;
+}
+
+// NULL: the pair can't be compared (arrays, mixed kinds, undefined slots)
+static const OrderKernel order_table[VAL_UNDEFINED + 1][VAL_UNDEFINED + 1] = {
+    [VAL_INT][VAL_INT] = order_int_int,
+    [VAL_INT][VAL_FLOAT] = order_int_float,
+    [VAL_FLOAT][VAL_INT] = order_float_int,
+    [VAL_FLOAT][VAL_FLOAT] = order_float_float,
+    [VAL_STRING][VAL_STRING] = order_string_string,
+    [VAL_BOOL][VAL_BOOL] = order_bool_bool,
+    [VAL_NULL][VAL_NULL] = order_null_null,
+};
+
+static const unsigned char order_holds[CMP_LE + 1][ORDER_UNORDERED + 1] = {
+    //          less equal greater unordered
+    [CMP_EQ] = { 0,   1,    0,      0 },
+    [CMP_NE] = { 1,   0,    1,      1 },
+    [CMP_GT] = { 0,   0,    1,      0 },
+    [CMP_LT] = { 1,   0,    0,      0 },
+    [CMP_GE] = { 0,   1,    1,      0 },
+    [CMP_LE] = { 1,   1,    0,      0 },
+};
+
+int compare_values(CompareOp op, Value left, Value right) {
+    OrderKernel order = order_table[left.type][right.type];
+    if (!order) return -1;
+    return order_holds[op][order(left, right)];
+}
+
+// Parse a whole string as a number; trailing garbage fails the cast
+static int parse_number(const char *text, int want_int, Value *result) {
+    char *end;
+    if (want_int) {
+        long n = strtol(text, &end, 10);
+        if (end == text || *end != '\0') return 0;
+        *result = int_value((int)n);
+    } else {
+        size_t length = strlen(text);
+        size_t used;
+        double d = parse_double(text, length, &used);
+        if (used == 0 || used != length) return 0;
+        *result = float_value(d);
+    }
+    return 1;
+}
+
+int cast_value(Value val, ValueType target, Value *result) {
+    switch (target) {
+        case VAL_INT:
+            switch (val.type) {
+                case VAL_INT: *result = val; return 1;
+                case VAL_FLOAT: *result = int_value((int)val.data.float_val); return 1;
+                case VAL_BOOL: *result = int_value(val.data.bool_val); return 1;
+                case VAL_STRING: return parse_number(val.data.string_val->chars, 1, result);
+                default: return 0;
+            }
+        
+        case VAL_FLOAT:
+            switch (val.type) {
+                case VAL_INT: *result = float_value(val.data.int_val); return 1;
+                case VAL_FLOAT: *result = val; return 1;
+                case VAL_BOOL: *result = float_value(val.data.bool_val); return 1;
+                case VAL_STRING: return parse_number(val.data.string_val->chars, 0, result);
+                default: return 0;
+            }
+        
+        case VAL_BOOL:
+            switch (val.type) {
+                case VAL_INT: *result = bool_value(val.data.int_val != 0); return 1;
+                case VAL_FLOAT: *result = bool_value(val.data.float_val != 0.0); return 1;
+                case VAL_BOOL: *result = val; return 1;
+                case VAL_STRING: *result = bool_value(val.data.string_val->length > 0); return 1;
+                case VAL_NULL: *result = bool_value(0); return 1;
+                default: return 0;
+            }
+        
+        case VAL_STRING: {
+            if (val.type == VAL_STRING) {
+                *result = retain_value(val);
+                return 1;
+            }
+            char buffer[SCALAR_TEXT_SIZE];
+            const char *chars;
+            int length;
+            if (!value_text(val, buffer, &chars, &length)) return 0;
+            *result = string_value_n(chars, length);
+            return 1;
+        }
+        
+        default:
+            return 0;
+    }
+}
+
+ValueType cast_target(TokenType cast) {
+    switch (cast) {
+        case TOKEN_INT_CAST: return VAL_INT;
+        case TOKEN_FLOAT_CAST: return VAL_FLOAT;
+        case TOKEN_STR_CAST: return VAL_STRING;
+        default: return VAL_BOOL;
+    }
+}
+
+void print_value(Value val) {
+    switch (val.type) {
+        case VAL_INT:
+            printf("%d", val.data.int_val);
+            break;
+        case VAL_FLOAT: {
+            char text[DOUBLE_TEXT_SIZE];
+            format_double(val.data.float_val, text);
+            fputs(text, stdout);
+            break;
+        }
+        case VAL_STRING:
+            fwrite(val.data.string_val->chars, 1, val.data.string_val->length, stdout);
+            break;
+        case VAL_BOOL:
+            printf("%s", val.data.bool_val ? "true" : "false");
+            break;
+        case VAL_ARRAY:
+            printf("{");
+            for (int i = 0; i < val.data.array_val->count; i++) {
+                print_value(val.data.array_val->elements[i]);
+                if (i < val.data.array_val->count - 1) printf(", ");
+            }
+            printf("}");
+            break;
+        case VAL_NULL:
+        case VAL_UNDEFINED:
+            printf("null");
+            break;
+    }
+}
+
+const char *value_type_name(ValueType type) {
+    switch (type) {
+        case VAL_INT: return "int";
+        case VAL_FLOAT: return "float";
+        case VAL_STRING: return "string";
+        case VAL_BOOL: return "bool";
+        case VAL_ARRAY: return "array";
+        case VAL_NULL: return "null";
+        case VAL_UNDEFINED: return "null";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,133 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include "token.h"
+
+// Value types
+typedef enum {
+    VAL_INT,
+    VAL_FLOAT,
+    VAL_STRING,
+    VAL_BOOL,
+    VAL_ARRAY,
+    VAL_NULL,
+    VAL_UNDEFINED        // internal: variable slot never assigned
+} ValueType;
+
+typedef struct StringObject StringObject;
+typedef struct ArrayObject ArrayObject;
+
+// Runtime value: a 16-byte tagged union passed and returned by value.
+// Only strings and arrays point at heap payloads.
+typedef struct Value {
+    ValueType type;
+    union {
+        int int_val;
+        double float_val;
+        StringObject *string_val;
+        int bool_val;
+        ArrayObject *array_val;
+    } data;
+} Value;
+
+// Heap payloads are reference counted and shared between copies.
+// Ratio values are still logically passed by value: anything that
+// mutates a payload must go through the *_for_write helpers first.
+struct StringObject {
+    int refcount;
+    int length;
+    int capacity;        // room for this many chars before the NUL
+    char chars[];        // NUL-terminated
+};
+
+struct ArrayObject {
+    int refcount;
+    int count;
+    Value elements[];
+};
+
+// Scalar constructors (no allocation)
+static inline Value int_value(int val) {
+    Value v = {VAL_INT, {.int_val = val}};
+    return v;
+}
+
+static inline Value float_value(double val) {
+    Value v = {VAL_FLOAT, {.float_val = val}};
+    return v;
+}
+
+static inline Value bool_value(int val) {
+    Value v = {VAL_BOOL, {.bool_val = val ? 1 : 0}};
+    return v;
+}
+
+static inline Value null_value(void) {
+    Value v = {VAL_NULL, {.int_val = 0}};
+    return v;
+}
+
+// Heap-backed constructors (refcount starts at 1)
+Value string_value(const char *val);
+Value string_value_n(const char *val, int length);
+Value array_value(int count);        // elements start out null
+
+// Share / drop a reference; both are no-ops for scalars
+static inline Value retain_value(Value val) {
+    if (val.type == VAL_STRING) {
+        val.data.string_val->refcount++;
+    } else if (val.type == VAL_ARRAY) {
+        val.data.array_val->refcount++;
+    }
+    return val;
+}
+
+void release_value(Value val);
+
+// Copy-on-write: make the payload unshared before mutating it in place
+StringObject *string_for_write(Value *val);
+ArrayObject *array_for_write(Value *val);
+
+// String helpers
+static inline const char *value_chars(Value val) {
+    return val.data.string_val->chars;
+}
+
+// Append to a string value, in place when its payload is unshared. The
+// buffer grows geometrically, so a run of appends is amortised O(1) each.
+void string_append(Value *val, const char *chars, int length);
+
+// concat: the text of left followed by the text of right (as str casts
+// would give them), stored into *dst. When *dst already holds left's
+// unshared payload it is extended in place. Returns 0 (and leaves *dst
+// alone) when an operand has no text form.
+int concat_values(Value *dst, Value left, Value right);
+
+int strings_equal(Value a, Value b);
+
+// Comparison operators, in the same order as TOKEN_EQ..TOKEN_LE,
+// TOKEN_JEQ..TOKEN_JLE and OP_EQ..OP_LE
+typedef enum {
+    CMP_EQ,
+    CMP_NE,
+    CMP_GT,
+    CMP_LT,
+    CMP_GE,
+    CMP_LE
+} CompareOp;
+
+// Compare through a table indexed by both operand types: ints and floats
+// (mixed too) compare numerically, strings bytewise, bools as false < true,
+// null equals null. Returns 1 or 0, or -1 when the types can't be compared.
+int compare_values(CompareOp op, Value left, Value right);
+
+// Conversions for int/float/str/bool casts; returns 0 (and leaves
+// *result alone) when val has no representation in the target type
+int cast_value(Value val, ValueType target, Value *result);
+ValueType cast_target(TokenType cast);     // TOKEN_INT_CAST -> VAL_INT, ...
+
+// Debug
+void print_value(Value val);
+const char *value_type_name(ValueType type);
+
+#endif
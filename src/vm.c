@@ -0,0 +1,894 @@
+#include "vm.h"
+#include "output.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Every frame's registers live in one preallocated stack: a callee's
+// frame starts right after its caller's
+#define STACK_REGISTERS (1 << 22)
+#define MAX_CALL_DEPTH (1 << 20)
+
+// Where to resume once the current call returns
+typedef struct {
+    Proto *proto;            // caller
+    const Instr *pc;
+    const CallSite *site;    // caller registers receiving the results
+    int base;                // caller's first register in the stack
+    int result_limit;        // results past this are null (narrowed by tail calls)
+} CallFrame;
+
+typedef struct {
+    Proto *proto;            // code being run
+    Value *registers;        // its frame
+    Value *stack;
+    CallFrame *frames;
+    int depth;
+} VM;
+
+// ==================== REGISTER HELPERS ====================
+
+static inline int is_heap_value(Value val) {
+    return val.type == VAL_STRING || val.type == VAL_ARRAY;
+}
+
+// Overwrite a register, dropping the reference it held
+static inline void store_register(Value *dst, Value val) {
+    Value old = *dst;
+    *dst = val;
+    if (is_heap_value(old)) release_value(old);
+}
+
+// Read a register on a slow path, reporting never-assigned variables
+static Value read_register(VM *vm, int reg) {
+    Value val = vm->registers[reg];
+    if (val.type != VAL_UNDEFINED) {
+        return val;
+    }
+    
+    runtime_error("Undefined variable '%s'",
+                  symbol_name(vm->proto->slot_names[reg]));
+    return null_value();
+}
+
+static int is_truthy(VM *vm, int reg) {
+    Value val = read_register(vm, reg);
+    if (val.type == VAL_BOOL) return val.data.bool_val;
+    if (val.type == VAL_INT) return val.data.int_val != 0;
+    return 0;
+}
+
+// ==================== SLOW PATHS ====================
+
+static inline double as_double(Value val) {
+    return val.type == VAL_FLOAT ? val.data.float_val : val.data.int_val;
+}
+
+// Arithmetic on anything but two ints (or an int division by zero)
+static void arith_values(int op, Value left, Value right, Value *dst) {
+    if (left.type == VAL_INT && right.type == VAL_INT) {
+        // Only a zero divisor gets here
+        runtime_error("%s by zero", op == OP_DIV ? "Division" : "Modulo");
+        store_register(dst, null_value());
+        return;
+    }
+    
+    if (op == OP_MOD || (left.type != VAL_FLOAT && right.type != VAL_FLOAT)) {
+        return;     // no result: the destination is left untouched
+    }
+    
+    double l = as_double(left);
+    double r = as_double(right);
+    switch (op) {
+        case OP_ADD: store_register(dst, float_value(l + r)); break;
+        case OP_SUB: store_register(dst, float_value(l - r)); break;
+        case OP_MUL: store_register(dst, float_value(l * r)); break;
+        case OP_DIV:
+            if (r == 0.0) {
+                runtime_error("Division by zero");
+                store_register(dst, null_value());
+            } else {
+                store_register(dst, float_value(l / r));
+            }
+            break;
+    }
+}
+
+static void arith_slow(VM *vm, const Instr *ip) {
+    Value left = read_register(vm, ip->b);
+    Value right = read_register(vm, ip->c);
+    arith_values(ip->op, left, right, &vm->registers[ip->a]);
+}
+
+static void arith_const_slow(VM *vm, const Instr *ip) {
+    Value left = read_register(vm, ip->b);
+    arith_values(OP_ADD + (ip->op - OP_ADDK), left, int_value(ip->c), &vm->registers[ip->a]);
+}
+
+// Comparisons and logic on anything but two ints (null when the operand
+// types don't fit)
+static Value relate_values(int op, Value left, Value right) {
+    if (op == OP_AND || op == OP_OR) {
+        if (left.type != VAL_BOOL || right.type != VAL_BOOL) return null_value();
+        return bool_value(op == OP_AND ? left.data.bool_val && right.data.bool_val
+                                       : left.data.bool_val || right.data.bool_val);
+    }
+    
+    int holds = compare_values((CompareOp)(op - OP_EQ), left, right);
+    return holds < 0 ? null_value() : bool_value(holds);
+}
+
+static void compare_slow(VM *vm, const Instr *ip) {
+    Value left = read_register(vm, ip->b);
+    Value right = read_register(vm, ip->c);
+    store_register(&vm->registers[ip->a], relate_values(ip->op, left, right));
+}
+
+// Compare-and-branch on anything but two ints: is the branch taken?
+// JMP_* jump when the comparison holds, JMPF_* when it doesn't
+static int branch_slow(VM *vm, const Instr *ip) {
+    int op = ip->op;
+    int jump_if = 1;
+    int constant = 0;
+    if (op >= OP_JMP_EQK) {
+        op -= OP_JMP_EQK;
+        constant = 1;
+    } else if (op >= OP_JMPF_EQK) {
+        op -= OP_JMPF_EQK;
+        constant = 1;
+        jump_if = 0;
+    } else if (op >= OP_JMPF_EQ) {
+        op -= OP_JMPF_EQ;
+        jump_if = 0;
+    } else {
+        op -= OP_JMP_EQ;
+    }
+    
+    Value left = read_register(vm, ip->a);
+    Value right = constant ? int_value(ip->b) : read_register(vm, ip->b);
+    return (compare_values((CompareOp)op, left, right) > 0) == jump_if;
+}
+
+static void step_slow(VM *vm, const Instr *ip) {
+    Value current = read_register(vm, ip->a);
+    int is_inc = (ip->op == OP_INC) || (ip->op == OP_INCK && !ip->c);
+    
+    if (current.type != VAL_INT) {
+        runtime_error("Can only %s integers",
+                      is_inc ? "increment" : "decrement");
+        return;
+    }
+    
+    // A non-integer amount counts as 1
+    Value *dst = &vm->registers[ip->a];
+    if (ip->op == OP_INCK) {
+        dst->data.int_val += ip->b;
+        return;
+    }
+    Value amount_val = read_register(vm, ip->b);
+    int amount = amount_val.type == VAL_INT ? amount_val.data.int_val : 1;
+    dst->data.int_val += is_inc ? amount : -amount;
+}
+
+static void index_array(VM *vm, const Instr *ip) {
+    Value array = read_register(vm, ip->b);
+    Value index_val = read_register(vm, ip->c);
+    
+    if (array.type != VAL_ARRAY) {
+        runtime_error("Not an array");
+        store_register(&vm->registers[ip->a], null_value());
+        return;
+    }
+    
+    if (index_val.type != VAL_INT) {
+        runtime_error("Array index must be integer");
+        store_register(&vm->registers[ip->a], null_value());
+        return;
+    }
+    
+    int index = index_val.data.int_val;
+    int count = array.data.array_val->count;
+    
+    // Handle negative indexing
+    if (index < 0) {
+        index = count + index;
+    }
+    
+    if (index < 0 || index >= count) {
+        runtime_error("Array index out of bounds");
+        store_register(&vm->registers[ip->a], null_value());
+        return;
+    }
+    
+    // Retain before the store in case the destination holds the array
+    store_register(&vm->registers[ip->a], retain_value(array.data.array_val->elements[index]));
+}
+
+static void concat_registers(VM *vm, const Instr *ip) {
+    Value left = read_register(vm, ip->b);
+    Value right = read_register(vm, ip->c);
+    
+    if (!concat_values(&vm->registers[ip->a], left, right)) {
+        runtime_error("Cannot concat %s and %s",
+                      value_type_name(left.type), value_type_name(right.type));
+        store_register(&vm->registers[ip->a], null_value());
+    }
+}
+
+static void cast_register(VM *vm, const Instr *ip) {
+    Value val = read_register(vm, ip->b);
+    Value result;
+    
+    if (!cast_value(val, ip->c, &result)) {
+        runtime_error("Cannot cast %s to %s",
+                      value_type_name(val.type), value_type_name(ip->c));
+        result = null_value();
+    }
+    store_register(&vm->registers[ip->a], result);
+}
+
+static void call_overflow(const CallSite *site) {
+    runtime_error("Call stack overflow in '%s'", symbol_name(site->name));
+    exit(1);
+}
+
+static void release_frame(Value *registers, int count) {
+    for (int i = 0; i < count; i++) {
+        if (is_heap_value(registers[i])) release_value(registers[i]);
+    }
+}
+
+// Check and normalise the hidden for-loop registers; returns 0 to skip the loop
+static int for_prepare(VM *vm, int base) {
+    Value *loop = &vm->registers[base];
+    Value start = read_register(vm, base);
+    Value end = read_register(vm, base + 1);
+    
+    if (start.type != VAL_INT || end.type != VAL_INT) {
+        runtime_error("For loop range must be integers");
+        return 0;
+    }
+    
+    // Fold the direction into the step so FORLOOP only has to add
+    int step = loop[2].type == VAL_INT ? loop[2].data.int_val : 1;
+    int ascending = start.data.int_val <= end.data.int_val;
+    store_register(&loop[2], int_value(ascending ? step : -step));
+    loop[3] = int_value(ascending);
+    return 1;
+}
+
+// ==================== DISPATCH ====================
+
+// Threaded dispatch: with GCC/Clang labels-as-values each instruction is
+// pre-decoded to its handler address and every handler ends in its own
+// indirect jump. Build with -DRATIO_SWITCH_DISPATCH (make DISPATCH=switch)
+// or use another compiler to get the portable switch loop instead.
+#if defined(__GNUC__) && !defined(RATIO_SWITCH_DISPATCH)
+#define USE_COMPUTED_GOTO 1
+#else
+#define USE_COMPUTED_GOTO 0
+#endif
+
+#if USE_COMPUTED_GOTO
+#define CASE(opcode) do_##opcode:
+#define NEXT() do { ip = pc++; goto *handlers[ip - code]; } while (0)
+#define DISPATCH_BEGIN NEXT();
+#define DISPATCH_END
+#else
+#define CASE(opcode) case opcode:
+#define NEXT() break
+#define DISPATCH_BEGIN for (;;) { ip = pc++; switch (ip->op) {
+#define DISPATCH_END } }
+#endif
+
+// Switch the dispatch state over to another frame's code
+#if USE_COMPUTED_GOTO
+#define ENTER(p) (vm.proto = proto = (p), K = proto->constants, code = proto->code, \
+                  handlers = proto->threaded)
+#else
+#define ENTER(p) (vm.proto = proto = (p), K = proto->constants, code = proto->code)
+#endif
+
+const char *vm_dispatch_mode(void) {
+    return USE_COMPUTED_GOTO ? "computed goto" : "switch";
+}
+
+#if USE_COMPUTED_GOTO
+// Site rewriting for arithmetic and comparisons. Each instruction starts
+// on its opcode's own handler, which repoints the instruction's threaded
+// slot at a handler for the operand types it sees, then runs the generic
+// code. The int, float and mixed handlers only check that their types
+// still hold (and that a divisor is non-zero) and go back to the opcode's
+// handler on a miss. A site that keeps missing is left on any_<opcode>,
+// the generic code on its own.
+typedef enum { SITE_INT, SITE_FLOAT, SITE_MIXED, SITE_ANY, SITE_KINDS } SiteKind;
+
+#define MAX_SITE_MISSES 16
+
+// Kind for the operands an instruction sees now. The first run is not a
+// miss, every later one is.
+static SiteKind specialise_site(VM *vm, const Instr *ip) {
+    unsigned char *runs = &vm->proto->site_runs[ip - vm->proto->code];
+    if (*runs > MAX_SITE_MISSES) return SITE_ANY;
+    if (++*runs > MAX_SITE_MISSES) return SITE_ANY;
+    
+    ValueType left = vm->registers[ip->b].type;
+    ValueType right = vm->registers[ip->c].type;
+    if (left == VAL_INT && right == VAL_INT) return SITE_INT;
+    if (left == VAL_FLOAT && right == VAL_FLOAT) return SITE_FLOAT;
+    if ((left == VAL_INT && right == VAL_FLOAT) || (left == VAL_FLOAT && right == VAL_INT)) {
+        return SITE_MIXED;
+    }
+    return SITE_ANY;
+}
+
+#define SITE_ENTRY(opcode) \
+    handlers[ip - code] = site_handlers[opcode - OP_ADD][specialise_site(&vm, ip)]; \
+    any_##opcode:
+
+#define INT_SITE(opcode, guard, result) \
+    int_##opcode: { \
+        Value l = R[ip->b], r = R[ip->c]; \
+        if (l.type != VAL_INT || r.type != VAL_INT) goto do_##opcode; \
+        int x = l.data.int_val, y = r.data.int_val; \
+        if (!(guard)) goto do_##opcode; \
+        store_register(&R[ip->a], result); \
+        NEXT(); \
+    }
+
+#define FLOAT_SITE(opcode, guard, result) \
+    float_##opcode: { \
+        Value l = R[ip->b], r = R[ip->c]; \
+        if (l.type != VAL_FLOAT || r.type != VAL_FLOAT) goto do_##opcode; \
+        double x = l.data.float_val, y = r.data.float_val; \
+        if (!(guard)) goto do_##opcode; \
+        store_register(&R[ip->a], result); \
+        NEXT(); \
+    }
+
+#define MIXED_SITE(opcode, guard, result) \
+    mixed_##opcode: { \
+        Value l = R[ip->b], r = R[ip->c]; \
+        double x, y; \
+        if (l.type == VAL_INT && r.type == VAL_FLOAT) { \
+            x = l.data.int_val; \
+            y = r.data.float_val; \
+        } else if (l.type == VAL_FLOAT && r.type == VAL_INT) { \
+            x = l.data.float_val; \
+            y = r.data.int_val; \
+        } else { \
+            goto do_##opcode; \
+        } \
+        if (!(guard)) goto do_##opcode; \
+        store_register(&R[ip->a], result); \
+        NEXT(); \
+    }
+
+#define SITE_ROW(opcode) \
+    [opcode - OP_ADD] = { &&int_##opcode, &&float_##opcode, &&mixed_##opcode, &&any_##opcode }
+#else
+// The switch loop keeps every check inline
+#define SITE_ENTRY(opcode)
+#endif
+
+// Two ints, then two floats, are handled inline; everything else (mixed
+// operands, strings, undefined variables) goes through arith_slow
+#define ARITH(opcode, operator) \
+    CASE(opcode) SITE_ENTRY(opcode) { \
+        Value l = R[ip->b], r = R[ip->c]; \
+        if (l.type == VAL_INT && r.type == VAL_INT) { \
+            store_register(&R[ip->a], int_value(l.data.int_val operator r.data.int_val)); \
+        } else if (l.type == VAL_FLOAT && r.type == VAL_FLOAT) { \
+            store_register(&R[ip->a], float_value(l.data.float_val operator r.data.float_val)); \
+        } else { \
+            arith_slow(&vm, ip); \
+        } \
+        NEXT(); \
+    }
+
+#define DIVIDE(opcode, operator) \
+    CASE(opcode) SITE_ENTRY(opcode) { \
+        Value l = R[ip->b], r = R[ip->c]; \
+        if (l.type == VAL_INT && r.type == VAL_INT && r.data.int_val != 0) { \
+            store_register(&R[ip->a], int_value(l.data.int_val operator r.data.int_val)); \
+        } else { \
+            arith_slow(&vm, ip); \
+        } \
+        NEXT(); \
+    }
+
+#define COMPARE(opcode, operator) \
+    CASE(opcode) SITE_ENTRY(opcode) { \
+        Value l = R[ip->b], r = R[ip->c]; \
+        if (l.type == VAL_INT && r.type == VAL_INT) { \
+            store_register(&R[ip->a], bool_value(l.data.int_val operator r.data.int_val)); \
+        } else { \
+            compare_slow(&vm, ip); \
+        } \
+        NEXT(); \
+    }
+
+#define ARITH_CONST(opcode, operator) \
+    CASE(opcode) { \
+        Value l = R[ip->b]; \
+        if (l.type == VAL_INT) { \
+            store_register(&R[ip->a], int_value(l.data.int_val operator ip->c)); \
+        } else { \
+            arith_const_slow(&vm, ip); \
+        } \
+        NEXT(); \
+    }
+
+#define BRANCH_UNLESS(opcode, operator) \
+    CASE(opcode) { \
+        Value l = R[ip->a], r = R[ip->b]; \
+        if (l.type == VAL_INT && r.type == VAL_INT ? !(l.data.int_val operator r.data.int_val) \
+                                                   : branch_slow(&vm, ip)) { \
+            pc = code + ip->c; \
+        } \
+        NEXT(); \
+    }
+
+#define BRANCH_IF(opcode, operator) \
+    CASE(opcode) { \
+        Value l = R[ip->a], r = R[ip->b]; \
+        if (l.type == VAL_INT && r.type == VAL_INT ? l.data.int_val operator r.data.int_val \
+                                                   : branch_slow(&vm, ip)) { \
+            pc = code + ip->c; \
+        } \
+        NEXT(); \
+    }
+
+#define BRANCH_IF_CONST(opcode, operator) \
+    CASE(opcode) { \
+        Value l = R[ip->a]; \
+        if (l.type == VAL_INT ? l.data.int_val operator ip->b : branch_slow(&vm, ip)) { \
+            pc = code + ip->c; \
+        } \
+        NEXT(); \
+    }
+
+#define BRANCH_UNLESS_CONST(opcode, operator) \
+    CASE(opcode) { \
+        Value l = R[ip->a]; \
+        if (l.type == VAL_INT ? !(l.data.int_val operator ip->b) : branch_slow(&vm, ip)) { \
+            pc = code + ip->c; \
+        } \
+        NEXT(); \
+    }
+
+void vm_run(Proto *proto) {
+    Proto *program = proto;
+    
+    VM vm;
+    vm.proto = proto;
+    vm.stack = malloc(sizeof(Value) * STACK_REGISTERS);
+    vm.frames = malloc(sizeof(CallFrame) * MAX_CALL_DEPTH);
+    vm.depth = 0;
+    vm.registers = vm.stack;
+    if (program->register_count > STACK_REGISTERS) {
+        runtime_error("Call stack overflow in '.main'");
+        exit(1);
+    }
+    for (int i = 0; i < proto->register_count; i++) {
+        vm.registers[i].type = VAL_UNDEFINED;
+    }
+    
+    Value *R = vm.registers;
+    const Value *K = proto->constants;
+    const Instr *code = proto->code;
+    const Instr *pc = code;
+    const Instr *ip;
+    
+#if USE_COMPUTED_GOTO
+    static const void *const labels[] = {
+        [OP_LOADK] = &&do_OP_LOADK,
+        [OP_LOADNULL] = &&do_OP_LOADNULL,
+        [OP_MOVE] = &&do_OP_MOVE,
+        [OP_ADD] = &&do_OP_ADD,
+        [OP_SUB] = &&do_OP_SUB,
+        [OP_MUL] = &&do_OP_MUL,
+        [OP_DIV] = &&do_OP_DIV,
+        [OP_MOD] = &&do_OP_MOD,
+        [OP_EQ] = &&do_OP_EQ,
+        [OP_NE] = &&do_OP_NE,
+        [OP_GT] = &&do_OP_GT,
+        [OP_LT] = &&do_OP_LT,
+        [OP_GE] = &&do_OP_GE,
+        [OP_LE] = &&do_OP_LE,
+        [OP_AND] = &&do_OP_AND,
+        [OP_OR] = &&do_OP_OR,
+        [OP_CONCAT] = &&do_OP_CONCAT,
+        [OP_INC] = &&do_OP_INC,
+        [OP_DEC] = &&do_OP_DEC,
+        [OP_ARRAY] = &&do_OP_ARRAY,
+        [OP_INDEX] = &&do_OP_INDEX,
+        [OP_CAST] = &&do_OP_CAST,
+        [OP_ECHO] = &&do_OP_ECHO,
+        [OP_JMP] = &&do_OP_JMP,
+        [OP_JMPF] = &&do_OP_JMPF,
+        [OP_JMP_EQ] = &&do_OP_JMP_EQ,
+        [OP_JMP_NE] = &&do_OP_JMP_NE,
+        [OP_JMP_GT] = &&do_OP_JMP_GT,
+        [OP_JMP_LT] = &&do_OP_JMP_LT,
+        [OP_JMP_GE] = &&do_OP_JMP_GE,
+        [OP_JMP_LE] = &&do_OP_JMP_LE,
+        [OP_FORPREP] = &&do_OP_FORPREP,
+        [OP_FORLOOP] = &&do_OP_FORLOOP,
+        [OP_CALL] = &&do_OP_CALL,
+        [OP_TAILCALL] = &&do_OP_TAILCALL,
+        [OP_RET] = &&do_OP_RET,
+        [OP_ADDK] = &&do_OP_ADDK,
+        [OP_SUBK] = &&do_OP_SUBK,
+        [OP_MULK] = &&do_OP_MULK,
+        [OP_INCK] = &&do_OP_INCK,
+        [OP_JMPF_EQ] = &&do_OP_JMPF_EQ,
+        [OP_JMPF_NE] = &&do_OP_JMPF_NE,
+        [OP_JMPF_GT] = &&do_OP_JMPF_GT,
+        [OP_JMPF_LT] = &&do_OP_JMPF_LT,
+        [OP_JMPF_GE] = &&do_OP_JMPF_GE,
+        [OP_JMPF_LE] = &&do_OP_JMPF_LE,
+        [OP_JMPF_EQK] = &&do_OP_JMPF_EQK,
+        [OP_JMPF_NEK] = &&do_OP_JMPF_NEK,
+        [OP_JMPF_GTK] = &&do_OP_JMPF_GTK,
+        [OP_JMPF_LTK] = &&do_OP_JMPF_LTK,
+        [OP_JMPF_GEK] = &&do_OP_JMPF_GEK,
+        [OP_JMPF_LEK] = &&do_OP_JMPF_LEK,
+        [OP_JMP_EQK] = &&do_OP_JMP_EQK,
+        [OP_JMP_NEK] = &&do_OP_JMP_NEK,
+        [OP_JMP_GTK] = &&do_OP_JMP_GTK,
+        [OP_JMP_LTK] = &&do_OP_JMP_LTK,
+        [OP_JMP_GEK] = &&do_OP_JMP_GEK,
+        [OP_JMP_LEK] = &&do_OP_JMP_LEK,
+        [OP_HALT] = &&do_OP_HALT,
+        [OP_UNIMPLEMENTED] = &&do_OP_UNIMPLEMENTED,
+        [OP_END] = &&do_OP_END,
+    };
+    _Static_assert(sizeof(labels) / sizeof(labels[0]) == OP_END + 1, "missing opcode handler");
+    
+    // Handler per SiteKind for each opcode from OP_ADD to OP_LE. Modulo
+    // has no float form: its float and mixed sites stay generic.
+    static const void *const site_handlers[][SITE_KINDS] = {
+        SITE_ROW(OP_ADD),
+        SITE_ROW(OP_SUB),
+        SITE_ROW(OP_MUL),
+        SITE_ROW(OP_DIV),
+        [OP_MOD - OP_ADD] = { &&int_OP_MOD, &&any_OP_MOD, &&any_OP_MOD, &&any_OP_MOD },
+        SITE_ROW(OP_EQ),
+        SITE_ROW(OP_NE),
+        SITE_ROW(OP_GT),
+        SITE_ROW(OP_LT),
+        SITE_ROW(OP_GE),
+        SITE_ROW(OP_LE),
+    };
+    _Static_assert(sizeof(site_handlers) / sizeof(site_handlers[0]) == OP_LE - OP_ADD + 1,
+                   "missing site handlers");
+    
+    // Pre-decode: one handler address per instruction, for .main and
+    // every function
+    for (int f = -1; f < program->function_count; f++) {
+        Proto *p = f < 0 ? program : program->functions[f];
+        int slots = p->code_count > 0 ? p->code_count : 1;
+        const void **threaded = malloc(sizeof(void *) * slots);
+        for (int i = 0; i < p->code_count; i++) {
+            threaded[i] = labels[p->code[i].op];
+        }
+        p->threaded = threaded;
+        p->site_runs = calloc(slots, 1);
+    }
+    const void **handlers = program->threaded;
+#endif
+    
+    DISPATCH_BEGIN
+    
+    CASE(OP_LOADK)
+        store_register(&R[ip->a], retain_value(K[ip->b]));
+        NEXT();
+    
+    CASE(OP_LOADNULL)
+        store_register(&R[ip->a], null_value());
+        NEXT();
+    
+    CASE(OP_MOVE)
+        if (R[ip->b].type != VAL_UNDEFINED) {
+            store_register(&R[ip->a], retain_value(R[ip->b]));
+        } else {
+            store_register(&R[ip->a], read_register(&vm, ip->b));
+        }
+        NEXT();
+    
+    ARITH(OP_ADD, +)
+    ARITH(OP_SUB, -)
+    ARITH(OP_MUL, *)
+    DIVIDE(OP_DIV, /)
+    DIVIDE(OP_MOD, %)
+    
+    COMPARE(OP_EQ, ==)
+    COMPARE(OP_NE, !=)
+    COMPARE(OP_GT, >)
+    COMPARE(OP_LT, <)
+    COMPARE(OP_GE, >=)
+    COMPARE(OP_LE, <=)
+    
+#if USE_COMPUTED_GOTO
+    // Division by zero goes back to the opcode's handler, which reports it.
+    // C's comparisons on NaN match compare_values(): only ne holds.
+    INT_SITE(OP_ADD, 1, int_value(x + y))
+    INT_SITE(OP_SUB, 1, int_value(x - y))
+    INT_SITE(OP_MUL, 1, int_value(x * y))
+    INT_SITE(OP_DIV, y != 0, int_value(x / y))
+    INT_SITE(OP_MOD, y != 0, int_value(x % y))
+    INT_SITE(OP_EQ, 1, bool_value(x == y))
+    INT_SITE(OP_NE, 1, bool_value(x != y))
+    INT_SITE(OP_GT, 1, bool_value(x > y))
+    INT_SITE(OP_LT, 1, bool_value(x < y))
+    INT_SITE(OP_GE, 1, bool_value(x >= y))
+    INT_SITE(OP_LE, 1, bool_value(x <= y))
+    
+    FLOAT_SITE(OP_ADD, 1, float_value(x + y))
+    FLOAT_SITE(OP_SUB, 1, float_value(x - y))
+    FLOAT_SITE(OP_MUL, 1, float_value(x * y))
+    FLOAT_SITE(OP_DIV, y != 0.0, float_value(x / y))
+    FLOAT_SITE(OP_EQ, 1, bool_value(x == y))
+    FLOAT_SITE(OP_NE, 1, bool_value(x != y))
+    FLOAT_SITE(OP_GT, 1, bool_value(x > y))
+    FLOAT_SITE(OP_LT, 1, bool_value(x < y))
+    FLOAT_SITE(OP_GE, 1, bool_value(x >= y))
+    FLOAT_SITE(OP_LE, 1, bool_value(x <= y))
+    
+    MIXED_SITE(OP_ADD, 1, float_value(x + y))
+    MIXED_SITE(OP_SUB, 1, float_value(x - y))
+    MIXED_SITE(OP_MUL, 1, float_value(x * y))
+    MIXED_SITE(OP_DIV, y != 0.0, float_value(x / y))
+    MIXED_SITE(OP_EQ, 1, bool_value(x == y))
+    MIXED_SITE(OP_NE, 1, bool_value(x != y))
+    MIXED_SITE(OP_GT, 1, bool_value(x > y))
+    MIXED_SITE(OP_LT, 1, bool_value(x < y))
+    MIXED_SITE(OP_GE, 1, bool_value(x >= y))
+    MIXED_SITE(OP_LE, 1, bool_value(x <= y))
+#endif
+    
+    CASE(OP_AND)
+    CASE(OP_OR)
+        compare_slow(&vm, ip);
+        NEXT();
+    
+    CASE(OP_CONCAT)
+        concat_registers(&vm, ip);
+        NEXT();
+    
+    CASE(OP_INC)
+    CASE(OP_DEC) {
+        Value *var = &R[ip->a];
+        Value amount = R[ip->b];
+        if (var->type == VAL_INT && amount.type == VAL_INT) {
+            var->data.int_val += (ip->op == OP_INC) ? amount.data.int_val : -amount.data.int_val;
+        } else {
+            step_slow(&vm, ip);
+        }
+        NEXT();
+    }
+    
+    CASE(OP_ARRAY) {
+        Value array = array_value(ip->c);
+        for (int i = 0; i < ip->c; i++) {
+            array.data.array_val->elements[i] = retain_value(R[ip->b + i]);
+        }
+        store_register(&R[ip->a], array);
+        NEXT();
+    }
+    
+    CASE(OP_INDEX)
+        index_array(&vm, ip);
+        NEXT();
+    
+    CASE(OP_CAST)
+        cast_register(&vm, ip);
+        NEXT();
+    
+    CASE(OP_ECHO)
+        if (ip->a >= 0) {
+            output_value(read_register(&vm, ip->a));
+        }
+        output_char(ip->c ? '\n' : ' ');
+        NEXT();
+    
+    CASE(OP_JMP)
+        pc = code + ip->a;
+        NEXT();
+    
+    CASE(OP_JMPF) {
+        Value cond = R[ip->a];
+        if (cond.type == VAL_BOOL ? !cond.data.bool_val : !is_truthy(&vm, ip->a)) {
+            pc = code + ip->b;
+        }
+        NEXT();
+    }
+    
+    CASE(OP_FORPREP)
+        if (!for_prepare(&vm, ip->a)) {
+            pc = code + ip->b;
+        } else if (ip->c >= 0) {
+            store_register(&R[ip->c], R[ip->a]);
+        }
+        NEXT();
+    
+    CASE(OP_FORLOOP) {
+        // Only reachable through FORPREP: the resolver rejects jumps into
+        // a loop body from outside it
+        Value *loop = &R[ip->a];
+        long long next = (long long)loop[0].data.int_val + loop[2].data.int_val;
+        if (loop[3].data.int_val ? next <= loop[1].data.int_val : next >= loop[1].data.int_val) {
+            loop[0].data.int_val = (int)next;
+            if (ip->c >= 0) {
+                Value *var = &R[ip->c];
+                if (var->type == VAL_INT) {
+                    var->data.int_val = (int)next;
+                } else {
+                    store_register(var, loop[0]);
+                }
+            }
+            pc = code + ip->b;
+        }
+        NEXT();
+    }
+    
+    CASE(OP_CALL) {
+        const CallSite *site = &proto->calls[ip->a];
+        Proto *callee = site->callee;
+        Value *frame = R + proto->register_count;
+        if (vm.depth == MAX_CALL_DEPTH || frame + callee->register_count > vm.stack + STACK_REGISTERS) {
+            call_overflow(site);
+        }
+        vm.frames[vm.depth++] = (CallFrame){ proto, pc, site, (int)(R - vm.stack), site->result_count };
+        
+        for (int i = 0; i < callee->register_count; i++) {
+            frame[i].type = VAL_UNDEFINED;
+        }
+        for (int i = 0; i < site->arg_count; i++) {
+            Value arg = R[site->args[i]];
+            if (arg.type == VAL_UNDEFINED) {
+                arg = read_register(&vm, site->args[i]);
+            }
+            if (i < callee->param_count) {
+                frame[i] = retain_value(arg);
+            }
+        }
+        
+        vm.registers = R = frame;
+        ENTER(callee);
+        pc = code;
+        NEXT();
+    }
+    
+    CASE(OP_TAILCALL) {
+        const CallSite *site = &proto->calls[ip->a];
+        Proto *callee = site->callee;
+        int passed = site->arg_count < callee->param_count ? site->arg_count : callee->param_count;
+        if (R + proto->register_count + passed > vm.stack + STACK_REGISTERS ||
+            R + callee->register_count > vm.stack + STACK_REGISTERS) {
+            call_overflow(site);
+        }
+        
+        // Stage the arguments past the end of this frame, drop the frame,
+        // then slide them down into the callee's parameter registers
+        Value *staged = R + proto->register_count;
+        for (int i = 0; i < site->arg_count; i++) {
+            Value arg = R[site->args[i]];
+            if (arg.type == VAL_UNDEFINED) {
+                arg = read_register(&vm, site->args[i]);
+            }
+            if (i < passed) {
+                staged[i] = retain_value(arg);
+            }
+        }
+        release_frame(R, proto->register_count);
+        for (int i = 0; i < passed; i++) {
+            R[i] = staged[i];
+        }
+        for (int i = passed; i < callee->register_count; i++) {
+            R[i].type = VAL_UNDEFINED;
+        }
+        
+        // Our caller only ever sees as many values as we passed on
+        CallFrame *frame = &vm.frames[vm.depth - 1];
+        if (site->result_count < frame->result_limit) {
+            frame->result_limit = site->result_count;
+        }
+        
+        ENTER(callee);
+        pc = code;
+        NEXT();
+    }
+    
+    CASE(OP_RET) {
+        CallFrame *frame = &vm.frames[--vm.depth];
+        const CallSite *site = frame->site;
+        Value *caller = vm.stack + frame->base;
+        int count = ip->b < frame->result_limit ? ip->b : frame->result_limit;
+        
+        // The frame is dying, so its values move to the caller as they are
+        for (int i = 0; i < site->result_count; i++) {
+            Value value = null_value();
+            if (i < count) {
+                value = R[ip->a + i];
+                R[ip->a + i].type = VAL_NULL;
+            }
+            store_register(&caller[site->results[i]], value);
+        }
+        release_frame(R, proto->register_count);
+        
+        vm.registers = R = caller;
+        ENTER(frame->proto);
+        pc = frame->pc;
+        NEXT();
+    }
+    
+    ARITH_CONST(OP_ADDK, +)
+    ARITH_CONST(OP_SUBK, -)
+    ARITH_CONST(OP_MULK, *)
+    
+    CASE(OP_INCK)
+        if (R[ip->a].type == VAL_INT) {
+            R[ip->a].data.int_val += ip->b;
+        } else {
+            step_slow(&vm, ip);
+        }
+        NEXT();
+    
+    BRANCH_UNLESS(OP_JMPF_EQ, ==)
+    BRANCH_UNLESS(OP_JMPF_NE, !=)
+    BRANCH_UNLESS(OP_JMPF_GT, >)
+    BRANCH_UNLESS(OP_JMPF_LT, <)
+    BRANCH_UNLESS(OP_JMPF_GE, >=)
+    BRANCH_UNLESS(OP_JMPF_LE, <=)
+    BRANCH_UNLESS_CONST(OP_JMPF_EQK, ==)
+    BRANCH_UNLESS_CONST(OP_JMPF_NEK, !=)
+    BRANCH_UNLESS_CONST(OP_JMPF_GTK, >)
+    BRANCH_UNLESS_CONST(OP_JMPF_LTK, <)
+    BRANCH_UNLESS_CONST(OP_JMPF_GEK, >=)
+    BRANCH_UNLESS_CONST(OP_JMPF_LEK, <=)
+    BRANCH_IF(OP_JMP_EQ, ==)
+    BRANCH_IF(OP_JMP_NE, !=)
+    BRANCH_IF(OP_JMP_GT, >)
+    BRANCH_IF(OP_JMP_LT, <)
+    BRANCH_IF(OP_JMP_GE, >=)
+    BRANCH_IF(OP_JMP_LE, <=)
+    BRANCH_IF_CONST(OP_JMP_EQK, ==)
+    BRANCH_IF_CONST(OP_JMP_NEK, !=)
+    BRANCH_IF_CONST(OP_JMP_GTK, >)
+    BRANCH_IF_CONST(OP_JMP_LTK, <)
+    BRANCH_IF_CONST(OP_JMP_GEK, >=)
+    BRANCH_IF_CONST(OP_JMP_LEK, <=)
+    
+    CASE(OP_HALT)
+        if (ip->a >= 0) {
+            output_value(read_register(&vm, ip->a));
+            output_char('\n');
+        }
+        goto done;
+    
+    CASE(OP_UNIMPLEMENTED)
+        runtime_error("Unimplemented node type %d", ip->a);
+        NEXT();
+    
+    CASE(OP_END)
+        goto done;
+    
+    DISPATCH_END
+    
+done:
+#if USE_COMPUTED_GOTO
+    for (int f = -1; f < program->function_count; f++) {
+        Proto *p = f < 0 ? program : program->functions[f];
+        free(p->threaded);
+        free(p->site_runs);
+        p->threaded = NULL;
+        p->site_runs = NULL;
+    }
+#endif
+    // A halt can stop the program inside any number of calls
+    release_frame(vm.stack, (int)(R - vm.stack) + proto->register_count);
+    free(vm.stack);
+    free(vm.frames);
+    output_flush();
+}
@@ -0,0 +1,12 @@
+#ifndef VM_H
+#define VM_H
+
+#include "compiler.h"
+
+// Execute a compiled program (.main and the functions it owns)
+void vm_run(Proto *proto);
+
+// Dispatch strategy compiled in ("computed goto" or "switch")
+const char *vm_dispatch_mode(void);
+
+#endif
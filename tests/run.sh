@@ -0,0 +1,28 @@
+#!/bin/sh
+# Run every tests/*.ratio on each backend and optimisation level and
+# compare stdout, stderr and the exit status with tests/<name>.out.
+# Usage: tests/run.sh [path/to/ratio]
+
+RATIO=${1:-./ratio}
+DIR=$(dirname "$0")
+ACTUAL=$(mktemp)
+trap 'rm -f "$ACTUAL"' EXIT
+
+failed=0
+total=0
+for test in "$DIR"/*.ratio; do
+    expected=${test%.ratio}.out
+    for mode in "" "--ast" "-O0" "--ast -O0"; do
+        total=$((total + 1))
+        $RATIO $mode "$test" > "$ACTUAL" 2>&1
+        echo "exit $?" >> "$ACTUAL"
+        if ! diff -u "$expected" "$ACTUAL" > /dev/null 2>&1; then
+            echo "FAIL: $test ${mode:-(vm)}"
+            diff -u "$expected" "$ACTUAL"
+            failed=$((failed + 1))
+        fi
+    done
+done
+
+echo "$((total - failed))/$total passed"
+[ "$failed" -eq 0 ]